@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace rflcs_graph {
+    struct match;
+}
+
+// the successors of all matches of one direction, in match order
+struct successor_lists {
+    std::vector<std::size_t> offsets = std::vector<std::size_t>();
+    std::vector<rflcs_graph::match *> successors = std::vector<rflcs_graph::match *>();
+
+    bool operator==(const successor_lists &) const = default;
+};
+
+/*
+ * The dominating successor lists as left by a pass of the graph reduction, restricted to active matches.
+ * A deactivated match has no successors, so it is neither extended nor chosen as a successor.
+ */
+struct reduction_snapshot {
+    successor_lists forward_successors = successor_lists();
+    successor_lists reverse_successors = successor_lists();
+
+    bool operator==(const reduction_snapshot &) const = default;
+};
+
+/*
+ * Lock-free hand-off between the heuristic (producer of lower bounds) and the graph reduction
+ * (producer of upper bounds and reduced successor lists) while both run on separate threads.
+ * The reduced graph is published as immutable snapshots tagged with an epoch. The reducer reduces the graph once
+ * for every lower bound the heuristic publishes, and the heuristic starts its next round on the snapshot of that
+ * reduction, so it switches snapshots at the same rounds in every run.
+ */
+struct bound_exchange {
+    std::atomic<int> lower_bound = 0;
+    std::atomic<int> upper_bound = std::numeric_limits<int>::max();
+    std::atomic<long> generation = 0; // bumped on every heuristic publication, waited on by the reducer
+    std::atomic<long> epoch = 0; // bumped on every reduction snapshot, polled by the heuristic
+    std::atomic<int> reduced_lower_bound = 0; // the latest snapshot and upper bound hold for it
+    std::atomic<bool> is_heuristic_ready = false;
+    std::atomic<bool> is_heuristic_done = false;
+    std::atomic<std::shared_ptr<const reduction_snapshot> > snapshot;
+
+    void publish_lower_bound(const int new_lower_bound) {
+        int current_lower_bound = lower_bound.load();
+        while (current_lower_bound < new_lower_bound
+               && !lower_bound.compare_exchange_weak(current_lower_bound, new_lower_bound)) {
+        }
+        notify_reducer();
+    }
+
+    void publish_upper_bound(const int new_upper_bound) {
+        int current_upper_bound = upper_bound.load();
+        while (current_upper_bound > new_upper_bound
+               && !upper_bound.compare_exchange_weak(current_upper_bound, new_upper_bound)) {
+        }
+    }
+
+    void publish_snapshot(std::shared_ptr<const reduction_snapshot> new_snapshot) {
+        snapshot.store(std::move(new_snapshot));
+        ++epoch;
+    }
+
+    void publish_reduction_done(const int lower_bound_of_reduction) {
+        reduced_lower_bound = lower_bound_of_reduction;
+        reduced_lower_bound.notify_all();
+    }
+
+    void wait_for_reduction(const int lower_bound_of_reduction) {
+        for (int seen_lower_bound = reduced_lower_bound.load();
+             seen_lower_bound < lower_bound_of_reduction;
+             seen_lower_bound = reduced_lower_bound.load()) {
+            reduced_lower_bound.wait(seen_lower_bound);
+        }
+    }
+
+    void publish_heuristic_ready() {
+        is_heuristic_ready = true;
+        notify_reducer();
+    }
+
+    void publish_heuristic_done() {
+        is_heuristic_done = true;
+        notify_reducer();
+    }
+
+    void wait_for_heuristic_ready() {
+        while (true) {
+            const long seen_generation = generation.load();
+            if (is_heuristic_ready) {
+                return;
+            }
+            generation.wait(seen_generation);
+        }
+    }
+
+private:
+    void notify_reducer() {
+        ++generation;
+        generation.notify_all();
+    }
+};
@@ -1,18 +1,95 @@
 #pragma once
 
+#include <cstddef>
+
+typedef unsigned long Character_set_block;
+
 #ifdef CHARACTER_SET_SIZE
 #include <bitset>
 
 struct Character_set : std::bitset<CHARACTER_SET_SIZE> {
     Character_set() = default;
+
+    explicit Character_set(Character_set_block *) {} // the bits are stored inline anyway
 };
 
+inline auto blocks_per_character_set() -> std::size_t {
+    return 0;
+}
+
 #else
 #include "constants.hpp"
 #include "boost/dynamic_bitset.hpp"
 
-struct Character_set : boost::dynamic_bitset<> {
-    Character_set() : dynamic_bitset(constants::alphabet_size) {}
+#include <memory>
+#include <type_traits>
+
+/*
+ * Hands out storage reserved by the owner of a set, e.g. the slab of an mdd node, and uses the heap otherwise.
+ * Copies never inherit the reserved storage.
+ */
+template<typename Block>
+struct character_set_allocator {
+    using value_type = Block;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+    using is_always_equal = std::false_type;
+
+    Block *storage = nullptr;
+    std::size_t storage_size = 0;
+
+    character_set_allocator() = default;
+
+    character_set_allocator(Block *storage, const std::size_t storage_size)
+        : storage(storage), storage_size(storage_size) {}
+
+    template<typename Other>
+    explicit character_set_allocator(const character_set_allocator<Other> &) {}
+
+    [[nodiscard]] Block *allocate(const std::size_t size) {
+        if (size <= storage_size) {
+            return storage;
+        }
+        return std::allocator<Block>().allocate(size);
+    }
+
+    void deallocate(Block *pointer, const std::size_t size) {
+        if (pointer != storage) {
+            std::allocator<Block>().deallocate(pointer, size);
+        }
+    }
+
+    [[nodiscard]] character_set_allocator select_on_container_copy_construction() const {
+        return character_set_allocator();
+    }
+
+    bool operator==(const character_set_allocator &other) const {
+        return storage == other.storage;
+    }
+};
+
+typedef boost::dynamic_bitset<Character_set_block, character_set_allocator<Character_set_block> > character_bitset;
+
+inline auto blocks_per_character_set() -> std::size_t {
+    return (constants::alphabet_size + character_bitset::bits_per_block - 1) / character_bitset::bits_per_block;
+}
+
+struct Character_set : character_bitset {
+    Character_set() : character_bitset(constants::alphabet_size) {}
+
+    explicit Character_set(Character_set_block *storage)
+        : character_bitset(constants::alphabet_size, 0, allocator_type(storage, blocks_per_character_set())) {}
+
+    Character_set(const Character_set &) = default;
+
+    // a moved buffer would stay in the reserved storage of the source, which is reused with its node, so it is copied
+    Character_set(Character_set &&other) : character_bitset(static_cast<const character_bitset &>(other)) {}
+
+    Character_set &operator=(const Character_set &) = default;
+
+    // the allocators compare unequal unless both sets use the heap, so only heap buffers are taken over
+    Character_set &operator=(Character_set &&) = default;
 };
 
 #endif
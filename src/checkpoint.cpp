@@ -0,0 +1,240 @@
+#include "checkpoint.hpp"
+#include "constants.hpp"
+#include "preprocessing.hpp"
+#include "mdd/header/initial_mdd.hpp"
+#include "mdd/shared_object.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+constexpr std::uint64_t CHECKPOINT_FORMAT = 3;
+
+struct checkpoint_header {
+    std::uint64_t format = CHECKPOINT_FORMAT;
+    int string_alphabet_size = 0;
+    int alphabet_size = 0; // followed by the original characters of the alphabet
+    std::size_t string_1_size = 0;
+    std::size_t string_2_size = 0;
+    std::size_t number_of_matches = 0;
+    int lower_bound = 0;
+    int upper_bound = 0;
+    int refinement_round = 1;
+    bool is_solving_forward = true;
+    std::size_t solution_size = 0;
+    std::size_t num_levels = 0;
+};
+
+template<typename Value>
+void write_value(std::ofstream &file, const Value &value) {
+    file.write(std::bit_cast<const char *>(&value), sizeof(Value));
+}
+
+template<typename Value>
+Value read_value(std::ifstream &file) {
+    auto value = Value();
+    file.read(std::bit_cast<char *>(&value), sizeof(Value));
+    return value;
+}
+
+void write_flat_levels(std::ofstream &file, const shared_object &shared_object);
+
+bool read_alphabet(std::ifstream &file, instance &instance, int alphabet_size);
+
+bool read_levels(std::ifstream &file, instance &instance, std::size_t num_levels);
+
+void write_checkpoint(const instance &instance) {
+    if (instance.checkpoint_path.empty()) {
+        return;
+    }
+    const auto &shared_object = *instance.shared_object;
+    const std::filesystem::path path(instance.checkpoint_path);
+    if (const std::filesystem::path dir = path.parent_path(); !dir.empty() && !exists(dir)) {
+        create_directories(dir);
+    }
+
+    const auto temp_path = std::filesystem::path(path.string() + ".tmp");
+    std::ofstream file(temp_path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open checkpoint file for writing." << std::endl;
+        return;
+    }
+    write_value(file, checkpoint_header{
+        .string_alphabet_size = instance.string_alphabet_size,
+        .alphabet_size = constants::alphabet_size,
+        .string_1_size = instance.string_1.size(),
+        .string_2_size = instance.string_2.size(),
+        .number_of_matches = instance.graph->matches.size(),
+        .lower_bound = instance.context.lower_bound,
+        .upper_bound = std::min(instance.context.upper_bound, shared_object.upper_bound),
+        .refinement_round = shared_object.refinement_round,
+        .is_solving_forward = instance.is_solving_forward,
+        .solution_size = instance.solution.size(),
+        .num_levels = shared_object.num_levels
+    });
+    for (Character character = 0; character < constants::alphabet_size; ++character) {
+        write_value(file, instance.original_characters.empty() ? character : instance.original_characters[character]);
+    }
+    for (const auto character: instance.solution) {
+        write_value(file, character);
+    }
+    write_flat_levels(file, shared_object);
+    file.close();
+    if (!file) {
+        std::cerr << "Failed to write checkpoint file." << std::endl;
+        return;
+    }
+
+    auto error_code = std::error_code();
+    std::filesystem::rename(temp_path, path, error_code);
+    if (error_code) {
+        std::cerr << "Failed to replace checkpoint file: " << error_code.message() << std::endl;
+    }
+}
+
+// edges are stored by the index of their node within the next level
+void write_flat_levels(std::ofstream &file, const shared_object &shared_object) {
+    const auto *flat_levels = shared_object.levels();
+    const auto *flat_nodes = shared_object.nodes();
+    const auto *flat_edges = shared_object.edges();
+    for (std::size_t level_index = 0; level_index < shared_object.num_levels; ++level_index) {
+        const auto &flat_level = flat_levels[level_index];
+        const auto next_level_first_node = flat_level.first_node + flat_level.num_nodes;
+        write_value(file, flat_level.depth);
+        write_value(file, static_cast<std::size_t>(flat_level.num_nodes));
+        for (auto node_index = flat_level.first_node; node_index < next_level_first_node; ++node_index) {
+            const auto &flat_node = flat_nodes[node_index];
+            write_value(file, flat_node.match_id);
+            write_value(file, shared_object.is_node_active(node_index));
+            write_value(file, static_cast<std::size_t>(flat_node.num_edges_out));
+            for (auto edge_index = flat_node.first_edge;
+                 edge_index < flat_node.first_edge + flat_node.num_edges_out;
+                 ++edge_index) {
+                write_value(file, flat_edges[edge_index].node_index - next_level_first_node);
+                write_value(file, shared_object.is_edge_active(edge_index));
+            }
+        }
+    }
+}
+
+PROCESSING_STATUS_CODE read_checkpoint(instance &instance, checkpoint_progress &progress) {
+    std::ifstream file(instance.checkpoint_path, std::ios::binary);
+    if (!file) {
+        std::cout << "Cannot find checkpoint file: " << instance.checkpoint_path << "." << std::endl;
+        return CHECKPOINT_ERROR;
+    }
+
+    const auto header = read_value<checkpoint_header>(file);
+    if (!file
+        || header.format != CHECKPOINT_FORMAT
+        || header.string_alphabet_size != instance.string_alphabet_size
+        || header.string_1_size != instance.string_1.size()
+        || header.string_2_size != instance.string_2.size()
+        || header.number_of_matches != instance.graph->matches.size()) {
+        std::cout << "Checkpoint file " << instance.checkpoint_path << " does not belong to this instance." << std::endl;
+        return CHECKPOINT_ERROR;
+    }
+    if (!read_alphabet(file, instance, header.alphabet_size)) {
+        std::cout << "Checkpoint file " << instance.checkpoint_path << " is damaged." << std::endl;
+        return CHECKPOINT_ERROR;
+    }
+    instance.context.lower_bound = header.lower_bound;
+    instance.context.upper_bound = std::max(std::min(instance.context.upper_bound, header.upper_bound),
+                                            header.lower_bound);
+    instance.is_solving_forward = header.is_solving_forward;
+    progress.refinement_round = header.refinement_round;
+    instance.solution.clear();
+    for (std::size_t solution_index = 0; solution_index < header.solution_size; ++solution_index) {
+        instance.solution.push_back(read_value<Character>(file));
+    }
+
+    if (!read_levels(file, instance, header.num_levels)) {
+        std::cout << "Checkpoint file " << instance.checkpoint_path << " is damaged." << std::endl;
+        return CHECKPOINT_ERROR;
+    }
+    return SUCCESS;
+}
+
+// the alphabet of the checkpoint is the one the reduced graph of its run compacted to
+bool read_alphabet(std::ifstream &file, instance &instance, const int alphabet_size) {
+    auto live_characters = std::vector<Character>();
+    for (int character_index = 0; character_index < alphabet_size; ++character_index) {
+        const auto original_character = read_value<Character>(file);
+        const auto character = instance.original_characters.empty()
+                                   ? original_character
+                                   : static_cast<Character>(std::ranges::find(instance.original_characters,
+                                                                              original_character)
+                                                            - instance.original_characters.begin());
+        if (!file || character < 0 || character >= constants::alphabet_size) {
+            return false;
+        }
+        live_characters.push_back(character);
+    }
+    if (alphabet_size < constants::alphabet_size) {
+        compact_alphabet(instance, live_characters);
+    }
+    return true;
+}
+
+// only active nodes and edges are restored, the edges of a level are linked once the next level exists
+bool read_levels(std::ifstream &file, instance &instance, const std::size_t num_levels) {
+    const auto number_of_match_ids = static_cast<int>(
+        instance.graph->matches.size() + instance.graph->reverse_matches.size());
+    auto &mdd_node_source = *instance.mdd_node_source;
+    auto mdd = std::make_unique<struct mdd>();
+    auto level_nodes = std::vector<node *>();
+    auto pending_edges = std::vector<std::pair<node *, std::uint32_t> >();
+    auto next_pending_edges = std::vector<std::pair<node *, std::uint32_t> >();
+    for (std::size_t level_index = 0; level_index < num_levels; ++level_index) {
+        auto &level = *mdd->levels.emplace_back(std::make_unique<level_type>());
+        level.depth = read_value<int>(file);
+        level_nodes.assign(read_value<std::size_t>(file), nullptr);
+        if (!file) {
+            return false;
+        }
+        for (auto &level_node: level_nodes) {
+            const auto match_id = read_value<int>(file);
+            const auto is_active = read_value<bool>(file);
+            const auto num_edges_out = read_value<std::size_t>(file);
+            if (!file || match_id < 0 || match_id >= number_of_match_ids) {
+                return false;
+            }
+            if (is_active) {
+                level_node = level_index == 0
+                                 ? create_root_node(instance, instance.is_solving_forward, mdd_node_source, instance.context)
+                                 : mdd_node_source.get_new_node_with_match(
+                                     *rflcs_graph::match_by_id(*instance.graph, match_id));
+                level.add_node(level_node);
+            }
+            for (std::size_t edge_index = 0; edge_index < num_edges_out; ++edge_index) {
+                const auto succ_index = read_value<std::uint32_t>(file);
+                if (read_value<bool>(file) && is_active) {
+                    next_pending_edges.emplace_back(level_node, succ_index);
+                }
+            }
+        }
+        for (const auto &[pred_node, succ_index]: pending_edges) {
+            if (succ_index >= level_nodes.size()) {
+                return false;
+            }
+            if (level_nodes[succ_index] != nullptr) {
+                pred_node->link_pred_to_succ(level_nodes[succ_index]);
+            }
+        }
+        std::swap(pending_edges, next_pending_edges);
+        next_pending_edges.clear();
+    }
+    if (!file) {
+        return false;
+    }
+    while (!mdd->levels.empty() && mdd->levels.back()->nodes.empty()) {
+        mdd->levels.pop_back();
+    }
+    instance.mdd = std::move(mdd);
+    return !instance.mdd->levels.empty();
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "input_processing.hpp"
+#include "instance.hpp"
+
+// progress of the mdd reduction rounds when the checkpoint was written
+struct checkpoint_progress {
+    int refinement_round = 1; // a resumed round starts from its first character selection
+};
+
+/*
+ * Saves the flat mdd of the reduction together with the bounds, the best solution, the direction and the progress.
+ * Matches are stored by their id, which only depends on the input, so the graph of a resumed run resolves them.
+ * The file is replaced by a rename, so a run killed while writing leaves the previous checkpoint behind.
+ * Nothing is written if the instance has no checkpoint path.
+ */
+void write_checkpoint(const instance &instance);
+
+// restores what write_checkpoint saved, the mdd is rebuilt from the active part of the flat mdd
+PROCESSING_STATUS_CODE read_checkpoint(instance &instance, checkpoint_progress &progress);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string_view>
 
 enum Ilp_Solver {
@@ -13,6 +14,14 @@ constexpr Ilp_Solver SOLVER = GUROBI_GRAPH_EDGES;
 
 constexpr int HEURISTIC_SOLUTION_DECREMENTER = 0;
 
+constexpr int REFINEMENT_BATCH_SIZE = 2; // characters split before the mdd is filtered again
+
+constexpr std::size_t RESTRICTED_MDD_INITIAL_WIDTH = 16;
+constexpr std::size_t RESTRICTED_MDD_MAX_WIDTH = 1024;
+
 constexpr int REDUCTION_TIMEOUT = 7200;
 constexpr int SOLVER_TIMEOUT = 1800;
+constexpr int MAX_LEVEL_WIDTH = 0;
+constexpr long MDD_MEMORY_LIMIT = 0;
+constexpr double INITIAL_MDD_ABORT_RATIO = 2;
 constexpr std::string_view DEFAULT_INPUT_FILE = "../RFLCS_instances/generated_instances/640_80.2";
\ No newline at end of file
@@ -3,3 +3,7 @@
 int constants::alphabet_size = 0;
 int constants::reduction_timeout = 0;
 int constants::solver_timeout = 0;
+int constants::max_level_width = 0;
+long constants::mdd_memory_limit = 0;
+bool constants::is_reduction_in_thread = false;
+double constants::initial_mdd_abort_ratio = 0;
@@ -1,7 +1,11 @@
 #pragma once
 
 struct constants {
-    static int alphabet_size;
+    static int alphabet_size; // final after the alphabet reduction by the reduced graph, before the mdd reduction
     static int reduction_timeout;
     static int solver_timeout;
+    static int max_level_width; // of the refined mdds, 0 for exact refinement, set to 0 once relaxed rounds stall
+    static long mdd_memory_limit; // of the node sources of a reduction round in MB, 0 for no limit
+    static bool is_reduction_in_thread; // instead of a forked child per round
+    static double initial_mdd_abort_ratio; // of the complexities of the two initial mdds, 0 to build both
 };
@@ -7,7 +7,7 @@
 
 #define MATCH_BINDINGS(P) \
 P##character, P##upper_bound, P##dom_succ_matches, \
-P##heuristic_characters, P##heuristic_successor_match, \
+P##heuristic_characters, P##heuristic_successor_match, P##heuristic_epoch, \
 P##reversed, P##extension, P##is_active
 
 namespace rflcs_graph {
@@ -35,6 +35,7 @@ namespace rflcs_graph {
         std::vector<match *> dom_succ_matches = std::vector<match *>();
         Character_set heuristic_characters;
         match* heuristic_successor_match;
+        int heuristic_epoch = 0; // heuristic_characters and heuristic_successor_match are only valid for this epoch
         match* reversed;
         match_extension* extension;
         bool is_active = true;
@@ -45,6 +46,14 @@ namespace rflcs_graph {
         std::vector<match> reverse_matches = std::vector<match>();
     };
 
+    // the ids count the matches first and the reverse matches after them
+    inline auto match_by_id(graph &graph, const int match_id) -> match * {
+        const auto number_of_matches = static_cast<int>(graph.matches.size());
+        return match_id < number_of_matches
+                   ? &graph.matches[match_id]
+                   : &graph.reverse_matches[match_id - number_of_matches];
+    }
+
     inline auto position_1_comparator(const match* first, const match* second) -> bool {
         return first->extension->position_1 < second->extension->position_1;
     }
@@ -24,7 +24,8 @@ auto manhattan_distance_comparator(const match &first, const match &second) -> b
 void set_successor_matches(const instance &instance,
                            vector<match> &matches,
                            const int_matrix &next_occurrences_1,
-                           const int_matrix &next_occurrences_2);
+                           const int_matrix &next_occurrences_2,
+                           scratch_space &scratch);
 
 void create_matches(std::vector<match> &matches,
                     const instance &instance,
@@ -38,6 +39,7 @@ void create_graph(instance &instance) {
     auto reversed_string_2 = instance.string_2;
     ranges::reverse(reversed_string_2);
 
+    instance.string_alphabet_size = constants::alphabet_size;
     instance.next_occurrences_1 = create_next_occurrences(constants::alphabet_size, instance.string_1);
     instance.next_occurrences_2 = create_next_occurrences(constants::alphabet_size, instance.string_2);
 
@@ -67,11 +69,13 @@ void create_graph(instance &instance) {
     set_successor_matches(instance,
                           instance.graph->matches,
                           instance.next_occurrences_1,
-                          instance.next_occurrences_2);
+                          instance.next_occurrences_2,
+                          instance.context.scratch);
     set_successor_matches(instance,
                           instance.graph->reverse_matches,
                           reverse_next_occurrences_1,
-                          reverse_next_occurrences_2);
+                          reverse_next_occurrences_2,
+                          instance.context.scratch);
 
     auto match_counter = 0;
     for (auto &[MATCH_BINDINGS()]: instance.graph->matches) {
@@ -178,7 +182,8 @@ auto count_occurrences(int alphabet_size,
 void set_successor_matches(const instance &instance,
                            vector<match> &matches,
                            const int_matrix &next_occurrences_1,
-                           const int_matrix &next_occurrences_2) {
+                           const int_matrix &next_occurrences_2,
+                           scratch_space &scratch) {
     const auto match_matrix = create_match_matrix(instance, matches);
 
     const auto string_1_length = instance.string_1.size();
@@ -198,8 +203,8 @@ void set_successor_matches(const instance &instance,
         }
         match.extension->succ_matches.shrink_to_fit();
 
-        static auto succ_matches_copy = vector<struct match *>(string_1_length);
-        std::ranges::fill(succ_matches_copy, nullptr);
+        auto &succ_matches_copy = scratch.succ_matches_by_position_1;
+        succ_matches_copy.assign(string_1_length, nullptr);
         for (const auto succ_match: match.extension->succ_matches) {
             succ_matches_copy[succ_match->extension->position_1] = succ_match;
         }
@@ -3,3 +3,5 @@
 #include "../../instance.hpp"
 
 bool deactivate_matches(instance& instance);
+
+void release_smart_pointers(rflcs_graph::match &match);
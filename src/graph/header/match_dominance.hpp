@@ -0,0 +1,5 @@
+#pragma once
+
+#include "../../instance.hpp"
+
+bool deactivate_dominated_matches(instance &instance);
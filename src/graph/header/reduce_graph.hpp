@@ -2,4 +2,4 @@
 
 #include "../../instance.hpp"
 
-void reduce_graph(rflcs_graph::graph &graph);
+void reduce_graph(rflcs_graph::graph &graph, solver_context &context);
@@ -4,4 +4,4 @@
 
 void setup_matches_for_simple_upper_bound(rflcs_graph::graph &graph);
 
-bool calculate_simple_upper_bounds(rflcs_graph::graph &graph);
+bool calculate_simple_upper_bounds(rflcs_graph::graph &graph, solver_context &context);
@@ -6,8 +6,6 @@
 #include <ranges>
 
 
-void release_smart_pointers(rflcs_graph::match &match);
-
 auto deactivate_matches(instance &instance) -> bool {
     bool deactivated_a_match = false;
     instance.active_matches = 0;
@@ -20,10 +18,10 @@ auto deactivate_matches(instance &instance) -> bool {
 
         for (auto const &succ: match.dom_succ_matches | active_match_pointer_filter) {
             for (auto const &pred: match.reversed->dom_succ_matches | active_match_pointer_filter) {
-                temporaries::temp_character_set_1 = succ->extension->available_characters;
-                temporaries::temp_character_set_1 |= pred->extension->available_characters;
-                temporaries::temp_character_set_1.set(match.character);
-                int specific_upper_bound = std::min(static_cast<int>(temporaries::temp_character_set_1.count()),
+                instance.context.scratch.temp_character_set_1 = succ->extension->available_characters;
+                instance.context.scratch.temp_character_set_1 |= pred->extension->available_characters;
+                instance.context.scratch.temp_character_set_1.set(match.character);
+                int specific_upper_bound = std::min(static_cast<int>(instance.context.scratch.temp_character_set_1.count()),
                                                     succ->upper_bound + pred->upper_bound + 1);
                 match.extension->combined_upper_bound = std::max(match.extension->combined_upper_bound,
                                                                  specific_upper_bound);
@@ -39,7 +37,7 @@ auto deactivate_matches(instance &instance) -> bool {
 
         match.reversed->extension->combined_upper_bound = match.extension->combined_upper_bound;
 
-        if (match.extension->combined_upper_bound <= temporaries::lower_bound) {
+        if (match.extension->combined_upper_bound <= instance.context.lower_bound) {
             deactivated_a_match = true;
             match.is_active = false;
             match.reversed->is_active = false;
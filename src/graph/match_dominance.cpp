@@ -0,0 +1,50 @@
+#include "graph.hpp"
+#include "header/match_dominance.hpp"
+#include "header/match_deactivation.hpp"
+#include "match_loop_utils.hpp"
+#include "../instance.hpp"
+
+#include <ranges>
+#include <vector>
+
+void mark_nearest_successors(std::vector<rflcs_graph::match> &matches, std::vector<char> &is_nearest_successor);
+
+/*
+ * A match that is no nearest successor of any active match is dominated: every active match before it
+ * reaches a match with the same character that is at or before it in both strings first.
+ * Such a match is unreachable from the root, so it can only be deactivated if the same holds in the reverse graph.
+ * Marking the successor lists of all active matches finds these matches in O(edges) instead of comparing pairs.
+ */
+auto deactivate_dominated_matches(instance &instance) -> bool {
+    auto &graph = *instance.graph;
+    auto &is_nearest_successor = instance.context.scratch.is_nearest_successor;
+    is_nearest_successor.assign(graph.matches.size() + graph.reverse_matches.size(), false);
+    mark_nearest_successors(graph.matches, is_nearest_successor);
+    mark_nearest_successors(graph.reverse_matches, is_nearest_successor);
+
+    bool deactivated_a_match = false;
+    for (auto &match: graph.matches
+                      | std::views::drop(1)
+                      | std::views::take(graph.matches.size() - 2)
+                      | active_match_filter) {
+        if (!is_nearest_successor[match.extension->match_id]
+            && !is_nearest_successor[match.reversed->extension->match_id]) {
+            deactivated_a_match = true;
+            match.is_active = false;
+            match.reversed->is_active = false;
+            instance.active_matches--;
+
+            release_smart_pointers(match);
+            release_smart_pointers(*match.reversed);
+        }
+    }
+    return deactivated_a_match;
+}
+
+void mark_nearest_successors(std::vector<rflcs_graph::match> &matches, std::vector<char> &is_nearest_successor) {
+    for (const auto &match: matches | active_match_filter) {
+        for (const auto *succ_match: match.extension->succ_matches) {
+            is_nearest_successor[succ_match->extension->match_id] = true;
+        }
+    }
+}
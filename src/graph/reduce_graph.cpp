@@ -4,41 +4,45 @@
 #include <vector>
 
 auto bad_edge(const rflcs_graph::match &current_match,
-              const rflcs_graph::match &target_match) -> bool;
+              const rflcs_graph::match &target_match,
+              solver_context &context) -> bool;
 
 auto bad_edge_with_exception(
     const rflcs_graph::match &current_match,
     const rflcs_graph::match &target_match,
-    const rflcs_graph::match &exception) -> bool;
+    const rflcs_graph::match &exception,
+    solver_context &context) -> bool;
 
 auto reduce_dominating_succ_edges(
     rflcs_graph::match &rev_root,
-    rflcs_graph::match &current_match) -> void;
+    rflcs_graph::match &current_match,
+    solver_context &context) -> void;
 
-auto reduce_succ_edges(rflcs_graph::match &current_match) -> void;
+auto reduce_succ_edges(rflcs_graph::match &current_match, solver_context &context) -> void;
 
-auto reduce_edges(std::vector<rflcs_graph::match> &matches) -> void;
+auto reduce_edges(std::vector<rflcs_graph::match> &matches, solver_context &context) -> void;
 
-auto reduce_graph(rflcs_graph::graph &graph) -> void {
-    reduce_edges(graph.matches);
-    reduce_edges(graph.reverse_matches);
+auto reduce_graph(rflcs_graph::graph &graph, solver_context &context) -> void {
+    reduce_edges(graph.matches, context);
+    reduce_edges(graph.reverse_matches, context);
 }
 
-auto reduce_edges(std::vector<rflcs_graph::match> &matches) -> void {
+auto reduce_edges(std::vector<rflcs_graph::match> &matches, solver_context &context) -> void {
     for (auto &current_match: matches) {
         if (current_match.is_active) {
-            reduce_succ_edges(current_match);
-            reduce_dominating_succ_edges(matches.back(), current_match);
+            reduce_succ_edges(current_match, context);
+            reduce_dominating_succ_edges(matches.back(), current_match, context);
         }
     }
 }
 
 auto reduce_dominating_succ_edges(
     rflcs_graph::match &rev_root,
-    rflcs_graph::match &current_match) -> void {
+    rflcs_graph::match &current_match,
+    solver_context &context) -> void {
     std::erase_if(current_match.dom_succ_matches,
-                  [&current_match, &rev_root](const rflcs_graph::match *succ_match) {
-                      return bad_edge_with_exception(current_match, *succ_match, rev_root);
+                  [&current_match, &rev_root, &context](const rflcs_graph::match *succ_match) {
+                      return bad_edge_with_exception(current_match, *succ_match, rev_root, context);
                   });
 
     if (current_match.dom_succ_matches.empty()) {
@@ -46,36 +50,38 @@ auto reduce_dominating_succ_edges(
     }
 }
 
-auto reduce_succ_edges(rflcs_graph::match &current_match) -> void {
+auto reduce_succ_edges(rflcs_graph::match &current_match, solver_context &context) -> void {
     std::erase_if(current_match.extension->succ_matches,
-                  [&current_match](const rflcs_graph::match *succ_match) {
-                      return bad_edge(current_match, *succ_match);
+                  [&current_match, &context](const rflcs_graph::match *succ_match) {
+                      return bad_edge(current_match, *succ_match, context);
                   });
 }
 
 inline auto bad_edge(
     const rflcs_graph::match &current_match,
-    const rflcs_graph::match &target_match) -> bool {
+    const rflcs_graph::match &target_match,
+    solver_context &context) -> bool {
     if (!target_match.is_active) {
         return true;
     }
-    if (current_match.reversed->upper_bound + target_match.upper_bound <= temporaries::lower_bound) {
+    if (current_match.reversed->upper_bound + target_match.upper_bound <= context.lower_bound) {
         return true;
     }
     if (current_match.reversed->upper_bound < target_match.extension->transient_match_domination_number) {
         return true;
     }
-    temporaries::temp_character_set_1 = current_match.reversed->extension->available_characters;
-    temporaries::temp_character_set_1 |= target_match.extension->available_characters;
-    return static_cast<int>(temporaries::temp_character_set_1.count()) <= temporaries::lower_bound;
+    context.scratch.temp_character_set_1 = current_match.reversed->extension->available_characters;
+    context.scratch.temp_character_set_1 |= target_match.extension->available_characters;
+    return static_cast<int>(context.scratch.temp_character_set_1.count()) <= context.lower_bound;
 }
 
 auto bad_edge_with_exception(
     const rflcs_graph::match &current_match,
     const rflcs_graph::match &target_match,
-    const rflcs_graph::match &exception) -> bool {
+    const rflcs_graph::match &exception,
+    solver_context &context) -> bool {
     if (&target_match == &exception) {
         return false;
     }
-    return bad_edge(current_match, target_match);
+    return bad_edge(current_match, target_match, context);
 }
@@ -5,7 +5,7 @@
 
 bool set_simple_upper_bounds(std::vector<rflcs_graph::match> &matches);
 
-bool calculate_simple_upper_bounds(rflcs_graph::graph &graph) {
+bool calculate_simple_upper_bounds(rflcs_graph::graph &graph, solver_context &context) {
     auto is_improving = set_simple_upper_bounds(graph.matches);
     is_improving |= set_simple_upper_bounds(graph.reverse_matches);
 
@@ -21,7 +21,7 @@ bool calculate_simple_upper_bounds(rflcs_graph::graph &graph) {
             reverse_upper_bound = std::max(reverse_upper_bound, dominating_match->upper_bound);
         }
     }
-    temporaries::upper_bound = std::min(upper_bound, reverse_upper_bound);
+    context.upper_bound = std::min(upper_bound, reverse_upper_bound);
     return is_improving;
 }
 
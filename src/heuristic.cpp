@@ -1,33 +1,73 @@
+#include "bound_exchange.hpp"
 #include "config.hpp"
 #include "constants.hpp"
 #include "heuristic.hpp"
 #include "instance.hpp"
-#include "reduction_orchestration.hpp"
-#include "temporaries.hpp"
 #include "graph/graph.hpp"
 #include "boost/timer/progress_display.hpp"
 #include "absl/container/flat_hash_set.h"
 
 #include <cmath>
 #include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
 #include <random>
+#include <span>
 #include <ranges>
 #include <vector>
 
-auto combine(instance &instance, std::vector<rflcs_graph::match> &matches, bool is_building_from_back) -> void;
+/*
+ * The heuristic runs concurrently with the graph reduction, which erases edges and deactivates matches.
+ * It therefore iterates the successor lists of the latest reduction snapshot the reducer published
+ * instead of the live dominating successor lists.
+ * Heuristic state written to a match is tagged with the heuristic epoch. Entries from older epochs read as the
+ * reset state, i.e. only the match character without a successor, so a reset is a single epoch increment.
+ */
+struct heuristic_view {
+    std::shared_ptr<const reduction_snapshot> snapshot = nullptr;
+    std::vector<Character_set> singleton_character_sets = std::vector<Character_set>(); // index alphabet_size is empty
+    std::vector<rflcs_graph::match *> candidate_matches = std::vector<rflcs_graph::match *>();
+    Character_set combined_characters = Character_set();
+    long snapshot_epoch = 0;
+    int heuristic_epoch = 1;
+    int lower_bound = 0;
+};
+
+inline auto heuristic_characters_of(const heuristic_view &view, const rflcs_graph::match &match) -> const Character_set & {
+    if (match.heuristic_epoch == view.heuristic_epoch) {
+        return match.heuristic_characters;
+    }
+    return view.singleton_character_sets[std::min(static_cast<int>(match.character), constants::alphabet_size)];
+}
+
+inline auto heuristic_successor_of(const heuristic_view &view, const rflcs_graph::match &match) -> const rflcs_graph::match * {
+    return match.heuristic_epoch == view.heuristic_epoch ? match.heuristic_successor_match : nullptr;
+}
 
-auto setup(const instance &instance) -> void;
+auto combine(instance &instance,
+             heuristic_view &view,
+             std::vector<rflcs_graph::match> &matches,
+             const successor_lists &successor_lists,
+             bool is_building_from_back) -> void;
 
-auto clear(const instance &instance) -> void;
+auto setup(const instance &instance, heuristic_view &view) -> void;
+
+auto apply_reduction_snapshot(const bound_exchange &bound_exchange, heuristic_view &view) -> void;
 
 auto
-set_heuristic_solution(instance &instance, const rflcs_graph::match &match, bool is_building_from_back) -> void;
+set_heuristic_solution(instance &instance,
+                       const heuristic_view &view,
+                       const rflcs_graph::match &match,
+                       bool is_building_from_back) -> void;
 
 auto heuristic_solve(instance &instance) -> void {
-    setup(instance);
+    auto &bound_exchange = *instance.bound_exchange;
+    auto view = heuristic_view();
+    setup(instance, view);
+    bound_exchange.publish_heuristic_ready();
 
     int lower_bound_before_round = 0;
-    temporaries::lower_bound = 0;
 
     int number_of_bad_runs = 0;
     int const number_of_bad_runs_limit = static_cast<int>(instance.string_1.size() * instance.string_2.size())
@@ -36,15 +76,27 @@ auto heuristic_solve(instance &instance) -> void {
     boost::timer::progress_display progress_display(number_of_bad_runs_limit);
 
     const auto reset_limit = round(sqrt(number_of_bad_runs_limit));
-    while (temporaries::lower_bound < temporaries::upper_bound &&
-           (lower_bound_before_round < temporaries::lower_bound || number_of_bad_runs < number_of_bad_runs_limit)) {
-        lower_bound_before_round = temporaries::lower_bound;
-
-        combine(instance, instance.graph->matches, true);
-        combine(instance, instance.graph->reverse_matches, false);
-
-        if (lower_bound_before_round < temporaries::lower_bound) {
-            reduce_graph_while_heuristic(instance);
+    while (true) {
+        // a new lower bound is reduced before the next round, so every run sees the same snapshots
+        bound_exchange.wait_for_reduction(view.lower_bound);
+        apply_reduction_snapshot(bound_exchange, view);
+        if (view.lower_bound >= bound_exchange.upper_bound ||
+            (lower_bound_before_round >= view.lower_bound && number_of_bad_runs >= number_of_bad_runs_limit)) {
+            break;
+        }
+        lower_bound_before_round = view.lower_bound;
+
+        combine(instance, view, instance.graph->matches, view.snapshot->forward_successors, true);
+        combine(instance, view, instance.graph->reverse_matches, view.snapshot->reverse_successors, false);
+
+        if (lower_bound_before_round < view.lower_bound) {
+            bound_exchange.publish_lower_bound(view.lower_bound);
+            const std::chrono::duration<double> heuristic_elapsed_seconds =
+                    std::chrono::system_clock::now() - instance.start;
+            std::cout << std::fixed << std::setprecision(2)
+                    << "\n"
+                    << "Heuristic found solution with length " << view.lower_bound << ", took "
+                    << heuristic_elapsed_seconds.count() << "s." << std::endl;
             number_of_bad_runs = 0;
             progress_display.restart(number_of_bad_runs_limit);
             reset_counter = 0;
@@ -55,81 +107,91 @@ auto heuristic_solve(instance &instance) -> void {
         }
         if (reset_counter > reset_limit) {
             reset_counter = 0;
-            clear(instance);
+            ++view.heuristic_epoch;
         }
     }
+
+    instance.heuristic_solution_length = view.lower_bound;
+    instance.heuristic_end = std::chrono::system_clock::now();
+    bound_exchange.publish_heuristic_done();
 }
 
-void setup(const instance &instance) {
+void setup(const instance &instance, heuristic_view &view) {
+    view.singleton_character_sets.resize(constants::alphabet_size + 1);
+    view.candidate_matches.resize(constants::alphabet_size);
+    for (int character = 0; character < constants::alphabet_size; ++character) {
+        view.singleton_character_sets[character].set(character);
+    }
     for (auto &[MATCH_BINDINGS()]: instance.graph->
          matches) {
-        heuristic_characters = Character_set();
-        heuristic_successor_match = nullptr;
-        reversed->heuristic_characters = Character_set();
-        reversed->heuristic_successor_match = nullptr;
-        if (character < constants::alphabet_size) {
-            heuristic_characters.set(character);
-            reversed->heuristic_characters.set(character);
-        }
+        heuristic_epoch = 0;
+        reversed->heuristic_epoch = 0;
     }
+    apply_reduction_snapshot(*instance.bound_exchange, view);
 }
 
-void clear(const instance &instance) {
-    for (auto &[character, upper_bound, _dom, heuristic_characters, heuristic_previous, reversed, extension, is_active]:
-         instance.graph->matches) {
-        if (is_active) {
-            heuristic_characters.reset();
-            reversed->heuristic_characters.reset();
-            if (character < constants::alphabet_size) {
-                heuristic_characters.set(character);
-                reversed->heuristic_characters.set(character);
-            }
-        }
+void apply_reduction_snapshot(const bound_exchange &bound_exchange, heuristic_view &view) {
+    if (const long epoch = bound_exchange.epoch.load(); epoch != view.snapshot_epoch) {
+        view.snapshot_epoch = epoch;
+        view.snapshot = bound_exchange.snapshot.load();
     }
 }
 
-void combine(instance &instance, std::vector<rflcs_graph::match> &matches, const bool is_building_from_back) {
-    auto static candidate_matches = std::vector<rflcs_graph::match *>(constants::alphabet_size);
-    for (auto &current_match: matches | std::views::reverse) {
-        if (current_match.is_active
-            && !current_match.dom_succ_matches.empty()) {
+void combine(instance &instance,
+             heuristic_view &view,
+             std::vector<rflcs_graph::match> &matches,
+             const successor_lists &successor_lists,
+             const bool is_building_from_back) {
+    auto &candidate_matches = view.candidate_matches;
+    auto &combined_characters = view.combined_characters;
+    for (auto match_index = static_cast<long>(matches.size()) - 1; match_index >= 0; --match_index) {
+        auto &current_match = matches[match_index];
+        const auto successors = std::span(successor_lists.successors)
+                .subspan(successor_lists.offsets[match_index],
+                         successor_lists.offsets[match_index + 1] - successor_lists.offsets[match_index]);
+        if (!successors.empty()) {
             int position = 0;
             unsigned long best_heuristic_score = 0;
-            for (auto *potential_match: current_match.dom_succ_matches) {
-                if (potential_match->is_active) {
-                    temporaries::temp_character_set_1 = current_match.reversed->heuristic_characters;
-                    temporaries::temp_character_set_1 |= potential_match->heuristic_characters;
-                    if (unsigned long const heuristic_score = temporaries::temp_character_set_1.count();
-                        heuristic_score > best_heuristic_score) {
-                        best_heuristic_score = heuristic_score;
-                        candidate_matches[0] = potential_match;
-                        position = 1;
-                    } else if (heuristic_score == best_heuristic_score) {
-                        candidate_matches[position] = potential_match;
-                        position++;
-                    }
+            for (auto *potential_match: successors) {
+                combined_characters = heuristic_characters_of(view, *current_match.reversed);
+                combined_characters |= heuristic_characters_of(view, *potential_match);
+                if (unsigned long const heuristic_score = combined_characters.count();
+                    heuristic_score > best_heuristic_score) {
+                    best_heuristic_score = heuristic_score;
+                    candidate_matches[0] = potential_match;
+                    position = 1;
+                } else if (heuristic_score == best_heuristic_score) {
+                    candidate_matches[position] = potential_match;
+                    position++;
                 }
             }
+            if (position == 0) {
+                continue;
+            }
 
             std::uniform_int_distribution uniform_distribution(0, position - 1);
 
             auto &chosen_match = *candidate_matches.at(uniform_distribution(instance.random));
             current_match.heuristic_successor_match = &chosen_match;
-            current_match.heuristic_characters = chosen_match.heuristic_characters;
+            current_match.heuristic_characters = heuristic_characters_of(view, chosen_match);
+            current_match.heuristic_epoch = view.heuristic_epoch;
             if (current_match.character < constants::alphabet_size) {
                 current_match.heuristic_characters.set(current_match.character);
             }
 
-            if (temporaries::lower_bound < static_cast<int>(best_heuristic_score) - HEURISTIC_SOLUTION_DECREMENTER) {
-                temporaries::lower_bound = static_cast<int>(best_heuristic_score) - HEURISTIC_SOLUTION_DECREMENTER;
-                set_heuristic_solution(instance, current_match, is_building_from_back);
+            if (view.lower_bound < static_cast<int>(best_heuristic_score) - HEURISTIC_SOLUTION_DECREMENTER) {
+                view.lower_bound = static_cast<int>(best_heuristic_score) - HEURISTIC_SOLUTION_DECREMENTER;
+                set_heuristic_solution(instance, view, current_match, is_building_from_back);
             }
         }
     }
 }
 
 void
-set_heuristic_solution(instance &instance, const rflcs_graph::match &match, const bool is_building_from_back) {
+set_heuristic_solution(instance &instance,
+                       const heuristic_view &view,
+                       const rflcs_graph::match &match,
+                       const bool is_building_from_back) {
     instance.heuristic_solution_time = std::chrono::system_clock::now();
     instance.solution.clear();
     auto characters = absl::flat_hash_set<int>();
@@ -140,7 +202,7 @@ set_heuristic_solution(instance &instance, const rflcs_graph::match &match, cons
             instance.solution.push_front(actual_match->character);
             characters.insert(actual_match->character);
         }
-        actual_match = actual_match->heuristic_successor_match;
+        actual_match = heuristic_successor_of(view, *actual_match);
     }
 
     actual_match = match.reversed;
@@ -149,7 +211,7 @@ set_heuristic_solution(instance &instance, const rflcs_graph::match &match, cons
             instance.solution.push_back(actual_match->character);
             characters.insert(actual_match->character);
         }
-        actual_match = actual_match->heuristic_successor_match;
+        actual_match = heuristic_successor_of(view, *actual_match);
     }
 
     if (is_building_from_back) {
@@ -72,20 +72,20 @@ void solve_gurobi_graph_dominating_matches_ilp(instance &instance) {
 
         model.setObjective(objective, GRB_MAXIMIZE);
 
-        model.addConstr(objective, GRB_GREATER_EQUAL, temporaries::lower_bound + 1);
+        model.addConstr(objective, GRB_GREATER_EQUAL, instance.context.lower_bound + 1);
 
         model.optimize();
 
         const auto result_status = model.get(GRB_IntAttr_Status);
         instance.is_valid_solution = result_status == GRB_OPTIMAL || result_status == GRB_INFEASIBLE;
         if (model.get(GRB_IntAttr_SolCount) > 0) {
-            temporaries::lower_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjVal)));
-            temporaries::upper_bound = temporaries::lower_bound;
+            instance.context.lower_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjVal)));
+            instance.context.upper_bound = instance.context.lower_bound;
             // TODO: set solution
         } else if (result_status == GRB_INFEASIBLE) {
-            temporaries::upper_bound = temporaries::lower_bound;
+            instance.context.upper_bound = instance.context.lower_bound;
         } else {
-            temporaries::upper_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjBound)));
+            instance.context.upper_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjBound)));
         }
 
     } catch (GRBException &e) {
@@ -11,7 +11,8 @@
 absl::flat_hash_map<std::pair<rflcs_graph::match *, rflcs_graph::match *>, GRBVar> get_gurobi_edges_map(
     GRBModel &model,
     const std::vector<rflcs_graph::match *> &matches,
-    rflcs_graph::match *sink);
+    rflcs_graph::match *sink,
+    const solver_context &context);
 
 std::vector<rflcs_graph::match *> get_active_matches(const instance &instance);
 
@@ -45,7 +46,7 @@ void solve_gurobi_graph_edges_ilp(instance &instance) {
         std::cout << root << std::endl;
         const auto sink = std::make_unique<rflcs_graph::match>();
 
-        auto gurobi_edges_map = get_gurobi_edges_map(model, matches, sink.get());
+        auto gurobi_edges_map = get_gurobi_edges_map(model, matches, sink.get(), instance.context);
 
         auto objective = GRBLinExpr();
         auto character_edge_sums = std::vector<GRBLinExpr>(constants::alphabet_size);
@@ -98,20 +99,20 @@ void solve_gurobi_graph_edges_ilp(instance &instance) {
         }
 
         model.setObjective(objective, GRB_MAXIMIZE);
-        model.addConstr(objective, GRB_GREATER_EQUAL, temporaries::lower_bound + 1);
+        model.addConstr(objective, GRB_GREATER_EQUAL, instance.context.lower_bound + 1);
 
         model.optimize();
 
         const auto result_status = model.get(GRB_IntAttr_Status);
         instance.is_valid_solution = result_status == GRB_OPTIMAL || result_status == GRB_INFEASIBLE;
         if (model.get(GRB_IntAttr_SolCount) > 0) {
-            temporaries::lower_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjVal)));
-            temporaries::upper_bound = temporaries::lower_bound;
+            instance.context.lower_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjVal)));
+            instance.context.upper_bound = instance.context.lower_bound;
             set_solution_from_edges(instance, gurobi_edges_map, sink.get(), root);
         } else if (result_status == GRB_INFEASIBLE) {
-            temporaries::upper_bound = temporaries::lower_bound;
+            instance.context.upper_bound = instance.context.lower_bound;
         } else {
-            temporaries::upper_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjBound)));
+            instance.context.upper_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjBound)));
         }
     } catch (GRBException &e) {
         std::cout << "Error code = " << e.getErrorCode() << std::endl;
@@ -122,13 +123,14 @@ void solve_gurobi_graph_edges_ilp(instance &instance) {
 absl::flat_hash_map<std::pair<rflcs_graph::match *, rflcs_graph::match *>, GRBVar> get_gurobi_edges_map(
     GRBModel &model,
     const std::vector<rflcs_graph::match *> &matches,
-    rflcs_graph::match *sink) {
+    rflcs_graph::match *sink,
+    const solver_context &context) {
     auto gurobi_edges_map = absl::flat_hash_map<std::pair<rflcs_graph::match *, rflcs_graph::match *>, GRBVar>();
     for (auto match: matches) {
         for (auto succ_match: match->extension->succ_matches) {
             gurobi_edges_map[std::make_pair(match, succ_match)] = model.addVar(0.0, 1.0, 0, GRB_BINARY);
         }
-        if (match->reversed->upper_bound > temporaries::lower_bound) {
+        if (match->reversed->upper_bound > context.lower_bound) {
             gurobi_edges_map[std::make_pair(match, sink)] = model.addVar(0.0, 1.0, 0, GRB_BINARY);
         }
     }
@@ -19,7 +19,8 @@ get_character_matches_map(const std::vector<rflcs_graph::match *> &matches);
 
 void set_objective_function(GRBModel &model,
                             const std::vector<rflcs_graph::match *> &matches,
-                            const absl::flat_hash_map<rflcs_graph::match *, GRBVar> &gurobi_variable_map);
+                            const absl::flat_hash_map<rflcs_graph::match *, GRBVar> &gurobi_variable_map,
+                            const solver_context &context);
 
 void set_repetition_free_constraint(GRBModel &model,
                                     const std::vector<rflcs_graph::match *> &matches,
@@ -27,7 +28,8 @@ void set_repetition_free_constraint(GRBModel &model,
 
 void set_common_sub_sequence_constraint(GRBModel &model,
                                         const std::vector<rflcs_graph::match *> &matches,
-                                        const absl::flat_hash_map<rflcs_graph::match *, GRBVar> &gurobi_variable_map);
+                                        const absl::flat_hash_map<rflcs_graph::match *, GRBVar> &gurobi_variable_map,
+                                        const solver_context &context);
 
 void solve_gurobi_graph_match_mis_ilp(instance &instance) {
     try {
@@ -59,8 +61,8 @@ void solve_gurobi_graph_match_mis_ilp(instance &instance) {
             gurobi_variable_map[match] = model.addVar(0.0, 1.0, 0.0, GRB_BINARY);
         }
 
-        set_objective_function(model, active_matches, gurobi_variable_map);
-        set_common_sub_sequence_constraint(model, active_matches, gurobi_variable_map);
+        set_objective_function(model, active_matches, gurobi_variable_map, instance.context);
+        set_common_sub_sequence_constraint(model, active_matches, gurobi_variable_map, instance.context);
         set_repetition_free_constraint(model, active_matches, gurobi_variable_map);
 
         model.optimize();
@@ -68,13 +70,13 @@ void solve_gurobi_graph_match_mis_ilp(instance &instance) {
         const auto result_status = model.get(GRB_IntAttr_Status);
         instance.is_valid_solution = result_status == GRB_OPTIMAL || result_status == GRB_INFEASIBLE;
         if (model.get(GRB_IntAttr_SolCount) > 0) {
-            temporaries::lower_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjVal)));
-            temporaries::upper_bound = temporaries::lower_bound;
+            instance.context.lower_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjVal)));
+            instance.context.upper_bound = instance.context.lower_bound;
             set_solution_from_matches(instance, active_matches, gurobi_variable_map);
         } else if (result_status == GRB_INFEASIBLE) {
-            temporaries::upper_bound = temporaries::lower_bound;
+            instance.context.upper_bound = instance.context.lower_bound;
         } else {
-            temporaries::upper_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjBound)));
+            instance.context.upper_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjBound)));
         }
     } catch (GRBException &e) {
         std::cout << "Error code = " << e.getErrorCode() << std::endl;
@@ -85,15 +87,16 @@ void solve_gurobi_graph_match_mis_ilp(instance &instance) {
 void set_common_sub_sequence_constraint(
     GRBModel &model,
     const std::vector<rflcs_graph::match *> &matches,
-    const absl::flat_hash_map<rflcs_graph::match *, GRBVar> &gurobi_variable_map) {
+    const absl::flat_hash_map<rflcs_graph::match *, GRBVar> &gurobi_variable_map,
+    const solver_context &context) {
     for (const auto match1: matches) {
         auto distant_crossing_matches = GRBLinExpr();
         for (const auto match2: matches) {
             if (match1->extension->position_1 < match2->extension->position_1
                 && match1->extension->position_2 > match2->extension->position_2) {
-                if (std::abs(match1->upper_bound - match2->upper_bound) < temporaries::upper_bound - temporaries::lower_bound
+                if (std::abs(match1->upper_bound - match2->upper_bound) < context.upper_bound - context.lower_bound
                     && std::abs(match1->reversed->upper_bound - match2->reversed->upper_bound) <
-                    temporaries::upper_bound - temporaries::lower_bound) {
+                    context.upper_bound - context.lower_bound) {
                     auto conflict = GRBLinExpr();
                     conflict += gurobi_variable_map.at(match1);
                     conflict += gurobi_variable_map.at(match2);
@@ -123,13 +126,14 @@ void set_repetition_free_constraint(
 
 void set_objective_function(GRBModel &model,
                             const std::vector<rflcs_graph::match *> &matches,
-                            const absl::flat_hash_map<rflcs_graph::match *, GRBVar> &gurobi_variable_map) {
+                            const absl::flat_hash_map<rflcs_graph::match *, GRBVar> &gurobi_variable_map,
+                            const solver_context &context) {
     auto objective = GRBLinExpr();
     for (const auto match: matches) {
         objective += gurobi_variable_map.at(match);
     }
     model.setObjective(objective, GRB_MAXIMIZE);
-    model.addConstr(objective, GRB_GREATER_EQUAL, temporaries::lower_bound + 1);
+    model.addConstr(objective, GRB_GREATER_EQUAL, context.lower_bound + 1);
 }
 
 absl::flat_hash_map<int, std::vector<rflcs_graph::match *> >
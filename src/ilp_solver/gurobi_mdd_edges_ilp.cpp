@@ -30,7 +30,8 @@ void model_mdd_traversal_constraints(const instance &instance,
 
 void model_lower_bound_levels_guidance(GRBModel &model,
                                        const absl::flat_hash_map<std::pair<int, std::pair<node *, node *> >, GRBVar>
-                                       &gurobi_edges_map);
+                                       &gurobi_edges_map,
+                                       const solver_context &context);
 
 void solve_gurobi_mdd_edges_ilp(instance &instance) {
     try {
@@ -66,10 +67,10 @@ void solve_gurobi_mdd_edges_ilp(instance &instance) {
 
         model_repetition_free_constraints(model, sink.get(), root, gurobi_edges_map);
         model_mdd_traversal_constraints(instance, model, sink.get(), root, gurobi_edges_map);
-        model_lower_bound_levels_guidance(model, gurobi_edges_map);
+        model_lower_bound_levels_guidance(model, gurobi_edges_map, instance.context);
 
         model.setObjective(objective, GRB_MAXIMIZE);
-        model.addConstr(objective, GRB_GREATER_EQUAL, temporaries::lower_bound + 1);
+        model.addConstr(objective, GRB_GREATER_EQUAL, instance.context.lower_bound + 1);
 
         //model.tune();
         model.optimize();
@@ -77,13 +78,13 @@ void solve_gurobi_mdd_edges_ilp(instance &instance) {
         const auto result_status = model.get(GRB_IntAttr_Status);
         instance.is_valid_solution = result_status == GRB_OPTIMAL || result_status == GRB_INFEASIBLE;
         if (model.get(GRB_IntAttr_SolCount) > 0) {
-            temporaries::lower_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjVal)));
-            temporaries::upper_bound = temporaries::lower_bound;
+            instance.context.lower_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjVal)));
+            instance.context.upper_bound = instance.context.lower_bound;
             set_solution_from_mdd_edges(instance, gurobi_edges_map, sink.get(), root);
         } else if (result_status == GRB_INFEASIBLE) {
-            temporaries::upper_bound = temporaries::lower_bound;
+            instance.context.upper_bound = instance.context.lower_bound;
         } else {
-            temporaries::upper_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjBound)));
+            instance.context.upper_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjBound)));
         }
     } catch
     (GRBException &e) {
@@ -103,7 +104,7 @@ get_gurobi_edges_map(
             for (const auto successor: node->edges_out) {
                 gurobi_edges_map[{level->depth, {node, successor}}] = model.addVar(0.0, 1.0, 0, GRB_BINARY);
             }
-            if (level->depth > temporaries::lower_bound) {
+            if (level->depth > instance.context.lower_bound) {
                 gurobi_edges_map[{level->depth, {node, sink}}] = model.addVar(0.0, 1.0, 0, GRB_BINARY);
             }
         }
@@ -173,13 +174,14 @@ void model_mdd_traversal_constraints(
 
 void model_lower_bound_levels_guidance(GRBModel &model,
                                        const absl::flat_hash_map<std::pair<int, std::pair<node *, node *> >, GRBVar>
-                                       &gurobi_edges_map) {
+                                       &gurobi_edges_map,
+                                       const solver_context &context) {
     auto level_edges_sums = absl::flat_hash_map<int, GRBLinExpr>();
-    for (int level = 0; level <= temporaries::lower_bound; ++level) {
+    for (int level = 0; level <= context.lower_bound; ++level) {
         level_edges_sums[level] = GRBLinExpr();
     }
     for (auto const &[level_from_to, variable]: gurobi_edges_map) {
-        if (level_from_to.first <= temporaries::lower_bound) {
+        if (level_from_to.first <= context.lower_bound) {
             level_edges_sums[level_from_to.first] += variable;
         }
     }
@@ -51,7 +51,7 @@ void solve_gurobi_mdd_nodes_ilp(instance &instance) {
                     model.addConstr(gurobi_variable_map.at(node), GRB_LESS_EQUAL, preds);
                 }
             }
-            if (level->depth <= temporaries::lower_bound + 1) {
+            if (level->depth <= instance.context.lower_bound + 1) {
                 model.addConstr(level_node_sum, GRB_EQUAL, 1);
             } else {
                 model.addConstr(level_node_sum, GRB_LESS_EQUAL, 1);
@@ -65,7 +65,7 @@ void solve_gurobi_mdd_nodes_ilp(instance &instance) {
         for (const auto& character_sum : character_sums) {
             model.addConstr(character_sum, GRB_LESS_EQUAL, 1);
         }
-        model.addConstr(objective, GRB_GREATER_EQUAL, temporaries::lower_bound + 1);
+        model.addConstr(objective, GRB_GREATER_EQUAL, instance.context.lower_bound + 1);
         model.setObjective(objective, GRB_MAXIMIZE);
 
         model.optimize();
@@ -73,13 +73,13 @@ void solve_gurobi_mdd_nodes_ilp(instance &instance) {
         const auto result_status = model.get(GRB_IntAttr_Status);
         instance.is_valid_solution = result_status == GRB_OPTIMAL || result_status == GRB_INFEASIBLE;
         if (model.get(GRB_IntAttr_SolCount) > 0) {
-            temporaries::lower_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjVal)));
-            temporaries::upper_bound = temporaries::lower_bound;
+            instance.context.lower_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjVal)));
+            instance.context.upper_bound = instance.context.lower_bound;
             set_solution_from_ilp(instance, gurobi_variable_map);
         } else if (result_status == GRB_INFEASIBLE) {
-            temporaries::upper_bound = temporaries::lower_bound;
+            instance.context.upper_bound = instance.context.lower_bound;
         } else {
-            temporaries::upper_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjBound)));
+            instance.context.upper_bound = static_cast<int>(round(model.get(GRB_DoubleAttr_ObjBound)));
         }
     } catch (GRBException &e) {
         std::cout << "Error code = " << e.getErrorCode() << std::endl;
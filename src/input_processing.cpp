@@ -16,7 +16,18 @@ PROCESSING_STATUS_CODE process_command_line_arguments(const int argc, char **arg
             ("reductiontimeout,r", boost::program_options::value<int>()->default_value(REDUCTION_TIMEOUT),
              "Reduction timeout [s]")
             ("solvertimeout,s", boost::program_options::value<int>()->default_value(SOLVER_TIMEOUT),
-             "Solver timeout [s]");
+             "Solver timeout [s]")
+            ("maxwidth,w", boost::program_options::value<int>()->default_value(MAX_LEVEL_WIDTH),
+             "Maximum number of nodes per level of the refined mdd, 0 for no limit")
+            ("mddmemory,m", boost::program_options::value<long>()->default_value(MDD_MEMORY_LIMIT),
+             "Memory limit of the mdd nodes of a reduction round [MB], 0 for no limit")
+            ("threadworker,t", "Run the mdd reduction rounds on a thread instead of a forked child")
+            ("abortratio,a", boost::program_options::value<double>()->default_value(INITIAL_MDD_ABORT_RATIO),
+             "Ratio of the complexities of the forward and backward initial mdd "
+             "at which the larger one is no longer built, 0 to build both")
+            ("checkpoint,c", boost::program_options::value<std::string>(),
+             "Checkpoint file path, written during the mdd reduction, no checkpoints if not given")
+            ("resume", "Continue the mdd reduction from the checkpoint given by --checkpoint");
 
     boost::program_options::variables_map vm;
     boost::program_options::store(boost::program_options::parse_command_line(argc, argv, command_line_description), vm);
@@ -32,8 +43,18 @@ PROCESSING_STATUS_CODE process_command_line_arguments(const int argc, char **arg
             vm.contains("output")
                 ? vm["output"].as<std::string>()
                 : get_default_output_path(instance.input_path);
+    instance.checkpoint_path = vm.contains("checkpoint") ? vm["checkpoint"].as<std::string>() : "";
+    instance.is_resuming = vm.contains("resume");
+    if (instance.is_resuming && instance.checkpoint_path.empty()) {
+        std::cout << "Resuming needs the checkpoint file given by --checkpoint." << std::endl;
+        return COMMAND_LINE_ERROR;
+    }
     constants::reduction_timeout = vm["reductiontimeout"].as<int>();
     constants::solver_timeout = vm["solvertimeout"].as<int>();
+    constants::max_level_width = vm["maxwidth"].as<int>();
+    constants::mdd_memory_limit = vm["mddmemory"].as<long>();
+    constants::is_reduction_in_thread = vm.contains("threadworker");
+    constants::initial_mdd_abort_ratio = vm["abortratio"].as<double>();
     return SUCCESS;
 }
 
@@ -59,8 +80,8 @@ PROCESSING_STATUS_CODE process_input(instance &instance) {
             return INPUT_FILE_ERROR;
         }
         constants::alphabet_size = parse_next_integer(input_file);
-        temporaries::upper_bound = constants::alphabet_size;
-        temporaries::lower_bound = 0;
+        instance.context.upper_bound = constants::alphabet_size;
+        instance.context.lower_bound = 0;
         const auto string_1_length = parse_next_integer(input_file);
         parse_string(instance.string_1, input_file, string_1_length);
         const auto string_2_length = parse_next_integer(input_file);
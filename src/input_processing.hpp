@@ -10,6 +10,7 @@ enum PROCESSING_STATUS_CODE {
     SUCCESS,
     COMMAND_LINE_ERROR,
     INPUT_FILE_ERROR,
+    CHECKPOINT_ERROR,
 };
 
 auto parse_next_integer(std::ifstream &input_file) -> int;
@@ -3,6 +3,7 @@
 #include "graph/graph.hpp"
 #include "mdd/mdd.hpp"
 #include "mdd/shared_object.hpp"
+#include "solver_context.hpp"
 
 #include <vector>
 #include <string>
@@ -16,6 +17,8 @@ using int_matrix = std::vector<int>;
 struct instance {
     std::string input_path;
     std::string output_path;
+    std::string checkpoint_path;
+    bool is_resuming = false;
     std::unique_ptr<rflcs_graph::graph> graph = nullptr;
     std::unique_ptr<struct mdd> mdd;
     std::unique_ptr<struct mdd_node_source> mdd_node_source;
@@ -27,6 +30,11 @@ struct instance {
     int_matrix next_occurrences_1 = int_matrix();
     std::vector<Character> string_2 = std::vector<Character>();
     int_matrix next_occurrences_2 = int_matrix();
+    int string_alphabet_size = 0; // width of the next occurrences, at least the alphabet size
+    std::vector<Character> original_characters = std::vector<Character>(); // indexed by compact character
+    std::vector<Character> forced_prefix = std::vector<Character>();
+    std::vector<Character> forced_suffix = std::vector<Character>(); // in order of removal, i.e. reversed
+    solver_context context = solver_context();
     int heuristic_solution_length = 0;
     std::mt19937 random = std::mt19937(0);
     bool is_valid_solution = false;
@@ -38,6 +46,7 @@ struct instance {
     int active_matches = std::numeric_limits<int>::max();
     int input_validity_code = 0;
     struct shared_object* shared_object = nullptr;
+    struct bound_exchange* bound_exchange = nullptr;
 
     int reduction_upper_bound = 0;
 };
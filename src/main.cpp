@@ -1,10 +1,11 @@
-#include "temporaries.hpp"
+#include "bound_exchange.hpp"
 #include "graph/header/graph_creation.hpp"
 #include "heuristic.hpp"
 #include "instance.hpp"
 #include "reduction_orchestration.hpp"
 #include "result_writer.hpp"
 #include "input_processing.hpp"
+#include "preprocessing.hpp"
 #include "config.hpp"
 #include "constants.hpp"
 #include "solver/sequence_enumeration_solver.hpp"
@@ -20,16 +21,19 @@
 #include <vector>
 #include <iomanip>
 #include <sys/resource.h>
+#include <thread>
 
 
-void initialize_temporaries();
+void initialize_context(instance &instance);
 
-void heuristic(instance &instance);
+void heuristic_and_graph_reduction(instance &instance);
 
 void print_heuristic_stats(const instance &instance);
 
 void reduction(instance &instance);
 
+PROCESSING_STATUS_CODE resume_reduction(instance &instance);
+
 void solve(instance &instance);
 
 void check_solution(instance &instance);
@@ -50,27 +54,40 @@ int main(const int argc, char **argv) {
             return 1;
         }
 
-        initialize_temporaries();
+        kernelize_strings(instance);
+        if (const auto preprocessing_status_code = reduce_alphabet(instance);
+            preprocessing_status_code != SUCCESS) {
+            return 1;
+        }
+
+        initialize_context(instance);
 
         instance.start = std::chrono::system_clock::now();
         create_graph(instance);
 
-        heuristic(instance);
-        instance.heuristic_solution_length = temporaries::lower_bound;
-        instance.heuristic_end = std::chrono::system_clock::now();
-        print_heuristic_stats(instance);
-
-        reduction(instance);
+        if (instance.is_resuming) {
+            if (const auto resume_status_code = resume_reduction(instance);
+                resume_status_code != SUCCESS) {
+                return 1;
+            }
+        } else {
+            heuristic_and_graph_reduction(instance);
+            print_heuristic_stats(instance);
+            reduce_graph_pre_solver(instance);
+            reduce_alphabet_by_graph(instance);
+            reduction(instance);
+        }
         instance.reduction_end = std::chrono::system_clock::now();
-        instance.reduction_upper_bound = temporaries::upper_bound;
-        if (temporaries::lower_bound >= temporaries::upper_bound) {
+        instance.reduction_upper_bound = instance.context.upper_bound;
+        if (instance.context.lower_bound >= instance.context.upper_bound) {
             std::cout << "Bounds converged, skipping solver." << std::endl;
         } else {
             solve(instance);
         }
-        temporaries::upper_bound = std::max(temporaries::upper_bound, temporaries::lower_bound);
+        instance.context.upper_bound = std::max(instance.context.upper_bound, instance.context.lower_bound);
         instance.end = std::chrono::system_clock::now();
         check_solution(instance);
+        lift_solution(instance);
 
         write_result_file(instance);
         print_result_stats(instance);
@@ -82,23 +99,26 @@ int main(const int argc, char **argv) {
     }
 }
 
-void initialize_temporaries() {
-    temporaries::temp_character_set_1 = Character_set();
-    temporaries::temp_character_set_2 = Character_set();
-    temporaries::old_characters_on_paths_to_some_sink = Character_set();
-    temporaries::old_characters_on_all_paths_to_lower_bound_levels = Character_set();
-    temporaries::old_characters_on_paths_to_root = Character_set();
-    temporaries::old_characters_on_all_paths_to_root = Character_set();
-    temporaries::chaining_numbers = std::vector<int>(constants::alphabet_size);
-    temporaries::node_character_count = std::vector<long>(constants::alphabet_size);
-    temporaries::incoming_edge_character_count = std::vector<long>(constants::alphabet_size);
-    temporaries::outgoing_edge_character_count = std::vector<long>(constants::alphabet_size);
+// the scratch space is sized by the alphabet, which is only final after the preprocessing
+void initialize_context(instance &instance) {
+    instance.context.chaining_numbers = std::vector<int>(constants::alphabet_size);
+    instance.context.scratch = scratch_space();
 }
 
-void heuristic(instance &instance) {
-    std::cout << "Heuristic started." << std::endl;
+void heuristic_and_graph_reduction(instance &instance) {
+    std::cout << "Heuristic and graph reduction started." << std::endl;
     std::flush(std::cout);
-    heuristic_solve(instance);
+    auto bound_exchange = ::bound_exchange();
+    bound_exchange.upper_bound = instance.context.upper_bound;
+    instance.bound_exchange = &bound_exchange;
+    publish_reduction_to_heuristic(instance);
+
+    auto heuristic_thread = std::jthread(heuristic_solve, std::ref(instance));
+    reduce_graph_while_heuristic(instance);
+    heuristic_thread.join();
+
+    instance.context.lower_bound = std::max(instance.context.lower_bound, bound_exchange.lower_bound.load());
+    instance.bound_exchange = nullptr;
 }
 
 void print_heuristic_stats(const instance &instance) {
@@ -108,15 +128,28 @@ void print_heuristic_stats(const instance &instance) {
 }
 
 void reduction(instance &instance) {
-    if (temporaries::lower_bound >= temporaries::upper_bound) {
-        temporaries::upper_bound = temporaries::lower_bound;
+    if (instance.context.lower_bound >= instance.context.upper_bound) {
+        instance.context.upper_bound = instance.context.lower_bound;
         instance.is_valid_solution = true;
         instance.active_matches = 0;
         return;
     }
     std::cout << "reduction is running." << std::endl;
-    reduce_graph_pre_solver(instance);
-    temporaries::upper_bound = std::max(temporaries::upper_bound, temporaries::lower_bound);
+    reduce_graph_pre_solver_by_mdd(instance);
+    instance.context.upper_bound = std::max(instance.context.upper_bound, instance.context.lower_bound);
+}
+
+// skips the heuristic and the graph reductions, their results are part of the checkpoint
+PROCESSING_STATUS_CODE resume_reduction(instance &instance) {
+    std::cout << "Resuming from checkpoint " << instance.checkpoint_path << "." << std::endl;
+    instance.heuristic_solution_time = instance.heuristic_end = std::chrono::system_clock::now();
+    if (const auto resume_status_code = resume_graph_pre_solver_by_mdd(instance);
+        resume_status_code != SUCCESS) {
+        return resume_status_code;
+    }
+    instance.heuristic_solution_length = instance.context.lower_bound;
+    instance.context.upper_bound = std::max(instance.context.upper_bound, instance.context.lower_bound);
+    return SUCCESS;
 }
 
 void solve(instance &instance) {
@@ -179,11 +212,11 @@ void check_solution(instance &instance) {
             return;
         }
         characters.insert(character);
-        position_1 = instance.next_occurrences_1[position_1 * constants::alphabet_size + character];
-        position_2 = instance.next_occurrences_2[position_2 * constants::alphabet_size + character];
+        position_1 = instance.next_occurrences_1[position_1 * instance.string_alphabet_size + character];
+        position_2 = instance.next_occurrences_2[position_2 * instance.string_alphabet_size + character];
     }
-    if (static_cast<int>(characters.size()) != temporaries::lower_bound) {
-        std::cout << "Solution lower bound " << temporaries::lower_bound << " does not fit solution length of "
+    if (static_cast<int>(characters.size()) != instance.context.lower_bound) {
+        std::cout << "Solution lower bound " << instance.context.lower_bound << " does not fit solution length of "
                 << characters.size() << ".\t";
         instance.is_valid_solution = false;
         return;
@@ -204,7 +237,7 @@ void print_result_stats(const instance &instance) {
                total_seconds.count(),
                reduction_seconds.count(),
                solver_seconds.count());
-    std::print("bounds: {}/{}\t", temporaries::upper_bound, temporaries::lower_bound);
+    std::print("bounds: {}/{}\t", instance.context.upper_bound, instance.context.lower_bound);
     std::print("solved: {}\t", instance.is_valid_solution ? "true" : "false");
 
     std::print("found solution: [");
@@ -1,14 +1,14 @@
 #include "header/character_bound_utils.hpp"
-#include "../temporaries.hpp"
 
 bool are_enough_characters_available(const int lower_bound,
                                      const int depth,
                                      const Character_set& pred_available_characters,
-                                     const Character_set& succ_available_characters) {
+                                     const Character_set& succ_available_characters,
+                                     scratch_space &scratch) {
     const auto current_size = pred_available_characters.count();
-    temporaries::temp_character_set_1 = pred_available_characters;
-    temporaries::temp_character_set_1 &= succ_available_characters;
-    const auto intersect_size = temporaries::temp_character_set_1.count();
+    scratch.temp_character_set_1 = pred_available_characters;
+    scratch.temp_character_set_1 &= succ_available_characters;
+    const auto intersect_size = scratch.temp_character_set_1.count();
     const auto optimal_character_usage_size = current_size - intersect_size;
     const auto minimal_overlap = std::max(0, static_cast<int>(depth - optimal_character_usage_size));
 
@@ -4,26 +4,34 @@
 #include "header/mdd_filter.hpp"
 #include "../constants.hpp"
 #include "edge_utils.hpp"
+#include "../worker_pool.hpp"
 #include "boost/timer/progress_display.hpp"
 #include "absl/container/flat_hash_set.h"
 
 #include <ranges>
 #include <algorithm>
+#include <mutex>
+#include <utility>
+#include <vector>
 
-void chaining_numbers(const mdd &mdd);
+void chaining_numbers(const mdd &mdd, solver_context &context);
 
-double calculate_greedy_score(const mdd &mdd, double initial_number_of_matches, double initial_number_of_graph_edges);
+double calculate_greedy_score(const mdd &mdd,
+                              double initial_number_of_matches,
+                              double initial_number_of_graph_edges,
+                              scratch_space &scratch);
 
 void update_characters_ordered_by_importance_mdd(
     std::vector<Character> &characters_ordered_by_importance,
     const instance &instance,
     const mdd &reduction_mdd,
-    mdd_node_source &mdd_node_source,
+    character_selection_workspace &workspace,
+    solver_context &context,
     boost::timer::progress_display *progress) {
-    chaining_numbers(reduction_mdd);
+    chaining_numbers(reduction_mdd, context);
 
     auto matches_on_level = absl::flat_hash_set<void *>();
-    auto static valid_edges = absl::flat_hash_set<long>();
+    auto &valid_edges = context.scratch.edges;
     valid_edges.clear();
     for (auto const &level: reduction_mdd.levels | std::ranges::views::drop(1)) {
         for (const auto node: level->nodes) {
@@ -37,27 +45,74 @@ void update_characters_ordered_by_importance_mdd(
         }
     }
     const unsigned long initial_number_of_matches = matches_on_level.size();
+    const unsigned long initial_number_of_graph_edges = valid_edges.size();
 
     auto greedy_scores = std::vector<double>(constants::alphabet_size);
+    auto candidates = std::vector<Character>();
     for (const auto split_character: characters_ordered_by_importance) {
-        if (temporaries::chaining_numbers[split_character] > 1) {
-            std::unique_ptr<mdd> mdd_character_selection = mdd::copy_mdd(reduction_mdd, mdd_node_source);
-            refine_mdd(*mdd_character_selection, split_character, mdd_node_source);
-            filter_mdd(instance, *mdd_character_selection, mdd_node_source);
-            greedy_scores[split_character] = calculate_greedy_score(
-                *mdd_character_selection,
-                static_cast<double>(initial_number_of_matches),
-                static_cast<double>(valid_edges.size())
-            );
-            mdd_character_selection->deconstruct(mdd_node_source);
+        if (context.chaining_numbers[split_character] > 1) {
+            candidates.push_back(split_character);
         } else {
             greedy_scores[split_character] = 0;
+            if (progress != nullptr) {
+                ++*progress;
+            }
+        }
+    }
+
+    /*
+     * Every candidate is refined and filtered on a restored copy of the mdd, starting from the bounds of the caller,
+     * so the scores do not depend on the worker or the order of evaluation.
+     */
+    auto &worker_pool = get_worker_pool();
+    if (workspace.workers.size() < worker_pool.number_of_workers()) {
+        workspace.workers.resize(worker_pool.number_of_workers());
+    }
+    auto trial_upper_bounds = std::vector<int>(worker_pool.number_of_workers(), context.upper_bound);
+    auto progress_mutex = std::mutex();
+    worker_pool.run(candidates.size(), [&](const std::size_t worker_index, const std::size_t task_index) {
+        // the scores are incomplete after a stop, the caller abandons the selection
+        if (context.stop_token.stop_requested()) {
+            return;
+        }
+        const auto split_character = candidates[task_index];
+        auto &worker = workspace.workers[worker_index];
+        if (worker.trial_mdd == nullptr) {
+            worker.trial_mdd = mdd::copy_mdd(reduction_mdd, *worker.node_source);
         }
+        worker.context.lower_bound = context.lower_bound;
+        worker.context.upper_bound = context.upper_bound;
+        worker.context.stop_token = context.stop_token;
+        worker.undo_log.begin_trial(*worker.trial_mdd, *worker.node_source);
+        refine_mdd(*worker.trial_mdd, split_character, *worker.node_source, worker.context);
+        filter_trial_mdd(*worker.trial_mdd, *worker.node_source, worker.context);
+        greedy_scores[split_character] = calculate_greedy_score(
+            *worker.trial_mdd,
+            static_cast<double>(initial_number_of_matches),
+            static_cast<double>(initial_number_of_graph_edges),
+            worker.context.scratch
+        );
+        worker.undo_log.roll_back(*worker.trial_mdd, *worker.node_source);
+        trial_upper_bounds[worker_index] = std::min(trial_upper_bounds[worker_index], worker.context.upper_bound);
 
         if (progress != nullptr) {
+            auto lock = std::scoped_lock(progress_mutex);
             ++*progress;
         }
+    });
+    for (auto &worker: workspace.workers) {
+        worker.trial_mdd = nullptr;
+        worker.node_source->release_all();
     }
+
+    // a refinement of the mdd is a relaxation as well, so the bounds found by the trials hold
+    if (const int trial_upper_bound = std::ranges::min(trial_upper_bounds); trial_upper_bound < context.upper_bound) {
+        context.upper_bound = trial_upper_bound;
+        if (instance.shared_object != nullptr) {
+            instance.shared_object->upper_bound = context.upper_bound;
+        }
+    }
+
     std::ranges::stable_sort(characters_ordered_by_importance,
                              [&greedy_scores](const Character character_1, const Character character_2) {
                                  return greedy_scores[character_1] > greedy_scores[character_2];
@@ -66,13 +121,14 @@ void update_characters_ordered_by_importance_mdd(
 
 double calculate_greedy_score(const mdd &mdd,
                               const double initial_number_of_matches,
-                              const double initial_number_of_graph_edges
+                              const double initial_number_of_graph_edges,
+                              scratch_space &scratch
 ) {
     auto number_of_mdd_nodes = 0.0;
-    auto static matches_on_level = absl::flat_hash_set<void *>();
-    auto static matches = absl::flat_hash_set<void *>();
+    auto &matches_on_level = scratch.matches_on_level;
+    auto &matches = scratch.matches;
     matches.clear();
-    auto static valid_edges = absl::flat_hash_set<long>();
+    auto &valid_edges = scratch.edges;
     valid_edges.clear();
     auto number_of_mdd_edges = 0.0;
     auto max_in_edges = 0.0;
@@ -106,33 +162,42 @@ double calculate_greedy_score(const mdd &mdd,
            / max_in_edges;
 }
 
-void chaining_numbers(const mdd &mdd) {
-    absl::flat_hash_map<node *, std::vector<int> > sequences_character_counter;
-    for (const auto node: mdd.levels.back()->nodes) {
-        sequences_character_counter[node] = std::vector<int>(constants::alphabet_size);
-        std::ranges::fill(sequences_character_counter[node], 0);
-        sequences_character_counter[node].at(node->character) = 1;
+/*
+ * The counters of a node hold, per character, the most nodes of that character on a path to the sink.
+ * They are computed bottom up with the counters of only two levels, stored by the level positions of the nodes.
+ */
+void chaining_numbers(const mdd &mdd, solver_context &context) {
+    const auto alphabet_size = static_cast<std::size_t>(constants::alphabet_size);
+    auto &counters = context.scratch.chaining_counters;
+    auto &succ_counters = context.scratch.succ_chaining_counters;
+
+    const auto &last_nodes = mdd.levels.back()->nodes;
+    counters.assign(last_nodes.size() * alphabet_size, 0);
+    for (const auto node: last_nodes) {
+        if (node->character < constants::alphabet_size) {
+            counters[node->level_position * alphabet_size + node->character] = 1;
+        }
     }
 
     for (int level_index = static_cast<int>(mdd.levels.size()) - 2; level_index >= 0; level_index--) {
-        for (const auto &level = mdd.levels.at(level_index); const auto node: level->nodes) {
-            sequences_character_counter[node] = std::vector<int>(constants::alphabet_size);
-            std::ranges::fill(sequences_character_counter[node], 0);
+        std::swap(counters, succ_counters);
+        const auto &level_nodes = mdd.levels[level_index]->nodes;
+        counters.assign(level_nodes.size() * alphabet_size, 0);
+        for (const auto node: level_nodes) {
+            int *node_counters = counters.data() + node->level_position * alphabet_size;
             for (const auto succ: node->edges_out) {
-                std::ranges::transform(
-                    sequences_character_counter[node],
-                    sequences_character_counter[succ],
-                    sequences_character_counter[node].begin(),
-                    [](const int first, const int second) {
-                        return std::max(first, second);
-                    });
-                sequences_character_counter[node].at(succ->character) = std::max(
-                    sequences_character_counter[node].at(succ->character),
-                    sequences_character_counter[succ].at(succ->character) + 1);
+                const int *succ_node_counters = succ_counters.data() + succ->level_position * alphabet_size;
+                // plain loop over both rows, which the compiler vectorizes
+                for (std::size_t character = 0; character < alphabet_size; ++character) {
+                    node_counters[character] = std::max(node_counters[character], succ_node_counters[character]);
+                }
+                node_counters[succ->character] = std::max(node_counters[succ->character],
+                                                          succ_node_counters[succ->character] + 1);
             }
         }
     }
 
-    const auto root = *mdd.levels.front()->nodes.begin();
-    temporaries::chaining_numbers = sequences_character_counter[root];
+    const auto root = mdd.levels.front()->nodes.front();
+    context.chaining_numbers.assign(counters.begin() + root->level_position * alphabet_size,
+                                    counters.begin() + (root->level_position + 1) * alphabet_size);
 }
@@ -2,5 +2,9 @@
 #include "../graph/graph.hpp"
 
 long match_pair_to_edge_long_encoding(const rflcs_graph::match *from, const rflcs_graph::match *to) {
-    return (static_cast<long>(from->extension->match_id) << 32) + static_cast<long>(to->extension->match_id);
+    return match_id_pair_to_edge_long_encoding(from->extension->match_id, to->extension->match_id);
+}
+
+long match_id_pair_to_edge_long_encoding(const int from_match_id, const int to_match_id) {
+    return (static_cast<long>(from_match_id) << 32) + static_cast<long>(to_match_id);
 }
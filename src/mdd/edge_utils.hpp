@@ -3,3 +3,5 @@
 #include "../graph/graph.hpp"
 
 long match_pair_to_edge_long_encoding(const rflcs_graph::match *from, const rflcs_graph::match *to);
+
+long match_id_pair_to_edge_long_encoding(int from_match_id, int to_match_id);
@@ -2,102 +2,134 @@
 #include "mdd.hpp"
 #include "absl/container/flat_hash_set.h"
 
-#include <map>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+std::size_t count_active_bits(const flat_activity_word *words, std::uint32_t end);
+
+flat_mdd_layout calculate_flat_mdd_layout(const std::size_t num_levels,
+                                          const std::size_t num_nodes,
+                                          const std::size_t num_edges) {
+    const auto words_for = [](const std::size_t count) {
+        return (count + FLAT_ACTIVITY_WORD_BITS - 1) / FLAT_ACTIVITY_WORD_BITS;
+    };
+    auto layout = flat_mdd_layout();
+    layout.level_capacity = num_levels;
+    layout.num_nodes = static_cast<std::uint32_t>(num_nodes);
+    layout.num_edges = static_cast<std::uint32_t>(num_edges);
+    layout.nodes_offset = num_levels * sizeof(flat_level);
+    layout.edges_offset = layout.nodes_offset + num_nodes * sizeof(flat_node);
+    const auto edges_end = layout.edges_offset + num_edges * sizeof(flat_edge);
+    layout.node_activity_offset = (edges_end + sizeof(flat_activity_word) - 1)
+                                  / sizeof(flat_activity_word) * sizeof(flat_activity_word);
+    layout.edge_activity_offset = layout.node_activity_offset + words_for(num_nodes) * sizeof(flat_activity_word);
+    layout.size = layout.edge_activity_offset + words_for(num_edges) * sizeof(flat_activity_word);
+    return layout;
+}
 
 size_t calculate_shared_object_size(const mdd& data) {
-    size_t size = 0;
-    size += sizeof(shared_object);
+    size_t num_nodes = 0;
+    size_t num_edges = 0;
     for (const auto& level : data.levels) {
-        size += sizeof(flat_level);
+        num_nodes += level->nodes.size();
         for (const auto node : level->nodes) {
-            size += sizeof(flat_node);
-            size += node->edges_out.size() * sizeof(flat_edge);
+            num_edges += node->edges_out.size();
         }
     }
-    return size;
+    return sizeof(shared_object) + calculate_flat_mdd_layout(data.levels.size(), num_nodes, num_edges).size;
 }
 
-void serialize_initial_mdd(const mdd& mdd, shared_object* shared_object) {
-    auto level_node_to_match = std::map<std::pair<int, void*>, flat_node*>();
-    auto* current_pointer = std::bit_cast<std::byte *>(shared_object);
-    shared_object->num_levels = mdd.levels.size();
-    current_pointer += sizeof(struct shared_object);
-
+// an edge points to the node at the level position of its successor within the next level
+void serialize_initial_mdd(const mdd& mdd, shared_object* shared_object, scratch_space& scratch) {
+    std::uint32_t num_nodes = 0;
+    std::uint32_t num_edges = 0;
     for (const auto& level : mdd.levels) {
-        auto flat_level = std::bit_cast<struct flat_level*>(current_pointer);
-        flat_level->depth = level->depth;
-        flat_level->num_nodes = level->nodes.size();
-        current_pointer += sizeof(struct flat_level);
-
+        num_nodes += static_cast<std::uint32_t>(level->nodes.size());
         for (const auto node : level->nodes) {
-            auto flat_node = std::bit_cast<struct flat_node*>(current_pointer);
-            flat_node->match_ptr = node->associated_match;
-            flat_node->character = node->character;
-            flat_node->position_2 = node->position_2;
-            flat_node->is_active = true;
-            flat_node->num_edges_out = node->edges_out.size();
-            level_node_to_match.try_emplace(std::make_pair(level->depth, node->associated_match), flat_node);
-            current_pointer += sizeof(struct flat_node);
-            current_pointer += sizeof(flat_edge) * node->edges_out.size();
+            num_edges += static_cast<std::uint32_t>(node->edges_out.size());
         }
     }
+    shared_object->layout = calculate_flat_mdd_layout(mdd.levels.size(), num_nodes, num_edges);
+    shared_object->num_levels = mdd.levels.size();
 
-    current_pointer = std::bit_cast<std::byte *>(shared_object);
-    current_pointer += sizeof(struct shared_object);
-
-    for (const auto& level : mdd.levels) {
-        current_pointer += sizeof(flat_level);
-
-        for (const auto node : level->nodes) {
-            current_pointer += sizeof(flat_node);
-
+    auto* flat_levels = shared_object->levels();
+    auto* flat_nodes = shared_object->nodes();
+    auto* flat_edges = shared_object->edges();
+    std::uint32_t node_index = 0;
+    std::uint32_t edge_index = 0;
+    for (std::size_t level_index = 0; level_index < mdd.levels.size(); ++level_index) {
+        const auto& level = *mdd.levels[level_index];
+        flat_levels[level_index] = flat_level{
+            .depth = level.depth,
+            .first_node = node_index,
+            .num_nodes = static_cast<std::uint32_t>(level.nodes.size())
+        };
+        const auto next_level_first_node = node_index + static_cast<std::uint32_t>(level.nodes.size());
+        for (const auto node : level.nodes) {
+            flat_nodes[node_index++] = flat_node{
+                .match_id = static_cast<rflcs_graph::match *>(node->associated_match)->extension->match_id,
+                .character = node->character,
+                .position_2 = node->position_2,
+                .first_edge = edge_index,
+                .num_edges_out = static_cast<std::uint32_t>(node->edges_out.size())
+            };
             for (const auto edge : node->edges_out) {
-                auto flat_edge = std::bit_cast<struct flat_edge*>(current_pointer);
-                flat_edge->edge_node = level_node_to_match[std::make_pair(level->depth + 1, edge->associated_match)];
-                flat_edge->is_active = true;
-                current_pointer += sizeof(struct flat_edge);
+                flat_edges[edge_index++].node_index = next_level_first_node + edge->level_position;
             }
         }
     }
-    shared_object->active_match_count = get_active_match_count(shared_object);
+
+    std::fill(shared_object->node_activity(), shared_object->edge_activity(), ~flat_activity_word{0});
+    std::fill(shared_object->edge_activity(),
+              std::bit_cast<flat_activity_word *>(&shared_object->flat_mdd[shared_object->layout.size]),
+              ~flat_activity_word{0});
+    shared_object->active_match_count = get_active_match_count(shared_object, scratch);
 }
 
-int get_active_match_count(shared_object* flat_mdd) {
-    auto static matches = absl::flat_hash_set<void*>();
+int get_active_match_count(shared_object* flat_mdd, scratch_space& scratch) {
+    auto& matches = scratch.active_match_ids;
     matches.clear();
-    auto current_pointer =  std::bit_cast<std::byte *>(flat_mdd);
-    current_pointer += sizeof(shared_object);
-    for (size_t level_index = 0; level_index < flat_mdd->num_levels; ++level_index) {
-        const auto *flat_level = std::bit_cast<struct flat_level*>(current_pointer);
-        current_pointer += sizeof(struct flat_level);
-        for (size_t node_index = 0; node_index < flat_level->num_nodes; ++node_index) {
-            auto flat_node = std::bit_cast<struct flat_node*>(current_pointer);
-            if(flat_node->is_active) {
-                matches.insert(flat_node->match_ptr);
-            }
-            current_pointer += sizeof(struct flat_node);
-            current_pointer += flat_node->num_edges_out * sizeof(flat_edge);
+    const auto* flat_nodes = flat_mdd->nodes();
+    const auto num_used_nodes = flat_mdd->num_used_nodes();
+    for (std::uint32_t node_index = 0; node_index < num_used_nodes; ++node_index) {
+        if (flat_mdd->is_node_active(node_index)) {
+            matches.insert(flat_nodes[node_index].match_id);
         }
     }
     return static_cast<int>(matches.size()) - 1;
 }
 
 int get_active_edge_count(shared_object* flat_mdd) {
-    int active_edge_count = 0;
-    auto current_pointer = std::bit_cast<std::byte *>(&flat_mdd->flat_levels);
-    for (size_t level_index = 0; level_index < flat_mdd->num_levels; ++level_index) {
-        const auto *flat_level = std::bit_cast<struct flat_level*>(current_pointer);
-        current_pointer += sizeof(struct flat_level);
-        for (size_t node_index = 0; node_index < flat_level->num_nodes; ++node_index) {
-            const auto *flat_node = std::bit_cast<struct flat_node*>(current_pointer);
-            current_pointer += sizeof(struct flat_node);
-            for (size_t edge_index = 0; edge_index < flat_node->num_edges_out; ++edge_index) {
-                if(const auto *flat_edge = std::bit_cast<struct flat_edge*>(current_pointer); flat_edge->is_active) {
-                    active_edge_count++;
-                }
-                current_pointer += sizeof(flat_edge);
-            }
-        }
+    return static_cast<int>(count_active_bits(flat_mdd->edge_activity(), flat_mdd->num_used_edges()));
+}
+
+// the bits from end onward are ignored
+std::size_t count_active_bits(const flat_activity_word *words, const std::uint32_t end) {
+    std::size_t count = 0;
+    const auto full_words = end / FLAT_ACTIVITY_WORD_BITS;
+    for (std::uint32_t word_index = 0; word_index < full_words; ++word_index) {
+        count += std::popcount(words[word_index]);
+    }
+    if (const auto remaining_bits = end % FLAT_ACTIVITY_WORD_BITS; remaining_bits != 0) {
+        count += std::popcount(words[full_words] & ((flat_activity_word{1} << remaining_bits) - 1));
+    }
+    return count;
+}
+
+void flat_delta_log::append(const flat_delta &delta) {
+    const auto position = write_count.load(std::memory_order_relaxed);
+    while (position - read_count.load(std::memory_order_acquire) >= FLAT_DELTA_LOG_CAPACITY) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    deltas[position % FLAT_DELTA_LOG_CAPACITY] = delta;
+    write_count.store(position + 1, std::memory_order_release);
+}
+
+void flat_delta_log::drain(std::vector<flat_delta> &drained_deltas) {
+    const auto end = write_count.load(std::memory_order_acquire);
+    for (auto position = read_count.load(std::memory_order_relaxed); position < end; ++position) {
+        drained_deltas.push_back(deltas[position % FLAT_DELTA_LOG_CAPACITY]);
     }
-    return active_edge_count;
+    read_count.store(end, std::memory_order_release);
 }
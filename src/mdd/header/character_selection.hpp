@@ -1,10 +1,31 @@
 #pragma once
 
 #include "../../instance.hpp"
+#include "../mdd_undo_log.hpp"
 #include "boost/timer/progress_display.hpp"
 
+#include <memory>
+#include <vector>
+
+/*
+ * A pool worker evaluating split characters. It copies the mdd once per character selection,
+ * refines and filters the copy in place for every candidate and rolls it back with its undo log.
+ */
+struct trial_worker {
+    std::unique_ptr<mdd_node_source> node_source = std::make_unique<mdd_node_source>();
+    solver_context context = solver_context();
+    std::unique_ptr<mdd> trial_mdd = nullptr;
+    mdd_undo_log undo_log = mdd_undo_log();
+};
+
+// kept across character selections, so the slabs and buffers of the trial workers are reused
+struct character_selection_workspace {
+    std::vector<trial_worker> workers = std::vector<trial_worker>();
+};
+
 void update_characters_ordered_by_importance_mdd(std::vector<Character> &characters_ordered_by_importance,
                                                  const instance &instance,
                                                  const mdd &reduction_mdd,
-                                                 mdd_node_source &mdd_node_source,
+                                                 character_selection_workspace &workspace,
+                                                 solver_context &context,
                                                  boost::timer::progress_display *progress);
@@ -2,6 +2,46 @@
 
 #include "../../instance.hpp"
 
-std::unique_ptr<mdd> create_initial_mdd(const instance &instance, bool forward);
+#include <atomic>
+#include <limits>
 
-void prune_by_flat_mdd(shared_object *shared_object, const mdd &mdd, mdd_node_source &mdd_node_source);
+/*
+ * Shared by the concurrent builds of the forward and the backward initial mdd. The first build to finish publishes
+ * the complexity of its filtered mdd, and the other one gives up as soon as the matches of its levels built so far
+ * exceed the abort ratio times that complexity. The ratio leaves room for the matches its filter would still remove,
+ * 0 builds both mdds completely.
+ */
+struct initial_mdd_race {
+    double abort_ratio = 0;
+    std::atomic<long> finished_complexity = std::numeric_limits<long>::max();
+
+    [[nodiscard]] bool is_losing(const long running_complexity) const {
+        return abort_ratio > 0
+               && static_cast<double>(running_complexity)
+               > abort_ratio * static_cast<double>(finished_complexity.load(std::memory_order_relaxed));
+    }
+};
+
+// nullptr if the build gave up the race
+std::unique_ptr<mdd> create_initial_mdd(const instance &instance,
+                                        bool forward,
+                                        mdd_node_source &mdd_node_source,
+                                        solver_context &context,
+                                        const initial_mdd_race &race);
+
+node *create_root_node(const instance &instance,
+                       bool forward,
+                       mdd_node_source &mdd_node_source,
+                       const solver_context &context);
+
+void prune_by_flat_mdd(shared_object *shared_object,
+                       const mdd &mdd,
+                       mdd_node_source &mdd_node_source,
+                       scratch_space &scratch);
+
+// prunes only the levels touched by the deltas of the flat mdd and drops the levels from num_levels on
+void prune_by_flat_deltas(std::vector<flat_delta> &deltas,
+                          std::size_t num_levels,
+                          const mdd &mdd,
+                          mdd_node_source &mdd_node_source,
+                          scratch_space &scratch);
@@ -2,6 +2,10 @@
 
 #include "../../instance.hpp"
 
-void filter_mdd(const instance &instance, mdd &mdd, mdd_node_source &mdd_node_source);
+void filter_mdd(const instance &instance, mdd &mdd, mdd_node_source &mdd_node_source, solver_context &context);
 
-void filter_flat_mdd(const instance &instance, const mdd &mdd, bool is_reporting);
+// leaves the shared object alone, e.g. for the trial mdds of the character selection which run concurrently
+void filter_trial_mdd(mdd &mdd, mdd_node_source &mdd_node_source, solver_context &context);
+
+// clears the flat entries which lost their counterpart in the mdd since the last call
+void filter_flat_mdd(const instance &instance, const mdd &mdd, mdd_flat_writeback &flat_writeback, bool is_reporting);
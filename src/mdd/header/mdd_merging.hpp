@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../../instance.hpp"
+
+/*
+ * Merges the nodes of a level which share their match, their successors and their character sets towards the sinks,
+ * the in-edges of a merged node move to its representative, which takes the union of the paths to the root.
+ * Such nodes lead to the same suffixes, so the paths and the bounds of the mdd stay the same.
+ * Meant for a filtered mdd, as the sets are compared as they are.
+ */
+void merge_equivalent_nodes(const mdd &mdd, mdd_node_source &mdd_node_source, solver_context &context);
+
+/*
+ * Merges nodes of the same match on a level wider than max_width, in level order until the level fits.
+ * A merged node has the union of the paths of both, so the mdd becomes a relaxation which keeps the bounds valid,
+ * but it may contain paths repeating a character. Returns whether any node was merged.
+ */
+bool relax_level(level_type &level, std::size_t max_width, mdd_node_source &mdd_node_source, scratch_space &scratch);
@@ -2,4 +2,7 @@
 
 #include "../../instance.hpp"
 
-void reduce_by_mdd(const instance &instance);
+#include <stop_token>
+
+// stops after the refinement batch during which a stop is requested or the memory limit is reached
+void reduce_by_mdd(const instance &instance, const std::stop_token &stop_token);
@@ -2,4 +2,11 @@
 
 #include "../../instance.hpp"
 
-void refine_mdd(const mdd &mdd, Character split_character, mdd_node_source &mdd_node_source);
+#include <span>
+
+void refine_mdd(mdd &mdd, Character split_character, mdd_node_source &mdd_node_source, solver_context &context);
+
+// splits by all characters before the mdd is filtered again, each node ends up in the product of their yes/no states.
+// Levels wider than constants::max_level_width are relaxed after the split.
+void refine_mdd(mdd &mdd, std::span<const Character> split_characters, mdd_node_source &mdd_node_source,
+                solver_context &context);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "../../instance.hpp"
+
+#include <mutex>
+#include <stop_token>
+#include <vector>
+
+// best solution of the restricted mdds, handed from their thread to the thread running the reduction rounds
+struct restricted_mdd_result {
+    std::mutex mutex = std::mutex();
+    int lower_bound = 0;
+    std::vector<Character> solution = std::vector<Character>();
+};
+
+/*
+ * Primal counterpart of the mdd reduction. Builds the forward mdd of the match graph level by level, but only keeps
+ * the most promising nodes of a level, ranked by their depth plus a bound on the remaining length.
+ * A node carries the exact set of used characters, so every path is a repetition-free common subsequence.
+ * Passes with doubling width run until the stop is requested, the upper bound is reached or the width exceeds
+ * RESTRICTED_MDD_MAX_WIDTH. The graph is only read, so it must not change while the passes run.
+ */
+void solve_by_restricted_mdd(std::stop_token stop_token,
+                             const instance &instance,
+                             int upper_bound,
+                             restricted_mdd_result &result);
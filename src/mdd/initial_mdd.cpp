@@ -2,80 +2,80 @@
 #include "header/domination_utils.hpp"
 #include "header/character_bound_utils.hpp"
 #include "mdd.hpp"
+#include "edge_utils.hpp"
 #include "../instance.hpp"
 #include "../graph/graph.hpp"
 #include "../constants.hpp"
-#include "absl/container/flat_hash_set.h"
-#include "absl/container/flat_hash_map.h"
 
+#include <algorithm>
 #include <memory>
+#include <utility>
 #include <vector>
 
-std::unique_ptr<mdd> create_initial_mdd(const instance &instance, const bool forward) {
+std::unique_ptr<mdd> create_initial_mdd(const instance &instance,
+                                        const bool forward,
+                                        mdd_node_source &mdd_node_source,
+                                        solver_context &context,
+                                        const initial_mdd_race &race) {
     auto mdd = std::make_unique<struct mdd>();
     mdd->levels = levels_type();
 
-    instance.mdd_node_source->sort_cache();
+    mdd_node_source.sort_cache();
 
-    auto &[root_level, first_level_depth, _rp] = *mdd->levels.emplace_back(std::make_unique<level_type>());
-    const auto root_node = instance.mdd_node_source->new_node();
-    root_node->is_active = true;
-    auto &root_match = forward ? instance.graph->matches.front() : instance.graph->reverse_matches.front();
-    root_node->associated_match = &root_match;
-    root_node->character = root_match.character;
-    root_node->position_1 = root_match.extension->position_1;
-    root_node->position_2 = root_match.extension->position_2;
-    root_node->characters_on_paths_to_root = Character_set();
-    root_node->characters_on_all_paths_to_root = Character_set();
-    root_node->characters_on_paths_to_some_sink = root_match.extension->available_characters;
-    root_node->characters_on_all_paths_to_lower_bound_levels = Character_set();
-    root_node->upper_bound_down = temporaries::upper_bound;
+    auto &root_level = *mdd->levels.emplace_back(std::make_unique<level_type>());
+    root_level.add_node(create_root_node(instance, forward, mdd_node_source, context));
 
-    root_level.push_back(root_node);
-
-    auto match_to_node_map = absl::flat_hash_map<rflcs_graph::match *, node *>();
-    while (!mdd->levels.back()->nodes.empty() && mdd->levels.back()->depth<temporaries::upper_bound) {
-        const auto &[current_nodes, current_depth, _p] = *mdd->levels.back();
-        auto &[next_nodes, next_depth, _np] = *mdd->levels.emplace_back(std::make_unique<level_type>());
-        next_depth = current_depth + 1;
-        match_to_node_map.clear();
+    // per match id, the depth of the latest level with a node of the match, 0 if none has been created yet,
+    // and that node, so the depth stamps the slots of the next level without clearing them per level
+    auto level_node_slots = std::vector<std::pair<int, node *> >(
+        instance.graph->matches.size() + instance.graph->reverse_matches.size(), {0, nullptr});
+    // the complexity of the mdd so far, i.e. the number of distinct matches of its levels
+    long running_complexity = 1;
+    while (!mdd->levels.back()->nodes.empty() && mdd->levels.back()->depth<context.upper_bound) {
+        if (race.is_losing(running_complexity)) {
+            return nullptr;
+        }
+        const auto &current_level = *mdd->levels.back();
+        const auto &current_nodes = current_level.nodes;
+        const int current_depth = current_level.depth;
+        auto &next_level = *mdd->levels.emplace_back(std::make_unique<level_type>());
+        const int next_depth = next_level.depth = current_depth + 1;
         for (const auto pred_node: current_nodes) {
             int min_position_2 = std::numeric_limits<int>::max();
             auto pred_node_match = static_cast<rflcs_graph::match*>(pred_node->associated_match);
+            const auto &pred_available_characters = pred_node_match->reversed->extension->available_characters;
             int min_positions_2_size = 0;
-            static auto min_positions_2 = std::vector<int>(constants::alphabet_size);
+            auto &min_positions_2 = context.scratch.min_positions_2;
             for (auto succ_match: pred_node_match->extension->succ_matches) {
-                const bool not_dominated = !dominated_by_some_available_but_unused_character(
-                    succ_match->extension->position_2, current_depth, min_positions_2, min_positions_2_size);
+                const auto &succ_extension = *succ_match->extension;
+                // the scalar bounds first, then the domination by the sorted positions, then the character sets
                 if (succ_match->character<constants::alphabet_size
-                                          && next_depth <= succ_match->reversed->upper_bound
-                                          && succ_match->extension->position_2<min_position_2
-                                                                              && pred_node->
-                                                                              characters_on_paths_to_some_sink.test(
-                                                                                  succ_match->character)
-                                                                              && next_depth + succ_match->upper_bound>
-                    temporaries::lower_bound
-                    && not_dominated
-                    && are_enough_characters_available(temporaries::lower_bound,
+                    && next_depth <= succ_match->reversed->upper_bound
+                    && next_depth + succ_match->upper_bound > context.lower_bound
+                    && succ_extension.position_2 < min_position_2
+                    && !dominated_by_some_available_but_unused_character(
+                        succ_extension.position_2, current_depth, min_positions_2, min_positions_2_size)
+                    && pred_node->characters_on_paths_to_some_sink.test(succ_match->character)
+                    && are_enough_characters_available(context.lower_bound,
                                                        next_depth,
-                                                       pred_node_match->reversed->extension->
-                                                       available_characters,
-                                                       succ_match->extension->available_characters)
+                                                       pred_available_characters,
+                                                       succ_extension.available_characters,
+                                                       context.scratch)
                 ) {
-                    if (!pred_node_match->reversed->extension->available_characters.test(
-                        succ_match->character)) {
-                        min_position_2 = std::min(min_position_2, succ_match->extension->position_2);
+                    if (!pred_available_characters.test(succ_match->character)) {
+                        min_position_2 = std::min(min_position_2, succ_extension.position_2);
                     } else {
-                        add_position_2_to_maybe_min_pos_2(min_positions_2, succ_match->extension->position_2, min_positions_2_size, current_depth);
+                        add_position_2_to_maybe_min_pos_2(min_positions_2, succ_extension.position_2, min_positions_2_size, current_depth);
                     }
                     if (succ_match->is_active) {
-                        node *succ_node;
-                        if (match_to_node_map.contains(succ_match)) {
-                            succ_node = match_to_node_map.at(succ_match);
-                        } else {
-                            succ_node = instance.mdd_node_source->get_new_node_with_match(*succ_match);
-                            match_to_node_map.insert({succ_match, succ_node});
-                            next_nodes.push_back(succ_node);
+                        auto &[slot_depth, succ_node] = level_node_slots[succ_extension.match_id];
+                        if (slot_depth != next_depth) {
+                            if (slot_depth == 0) {
+                                ++running_complexity;
+                            }
+                            slot_depth = next_depth;
+                            succ_node = mdd_node_source.get_new_node_with_match(*succ_match);
+                            next_level.add_node(succ_node);
                         }
                         pred_node->link_pred_to_succ(succ_node);
                     }
@@ -90,42 +90,63 @@ std::unique_ptr<mdd> create_initial_mdd(const instance &instance, const bool for
     return mdd;
 }
 
-void prune_by_flat_mdd(shared_object *shared_object, const mdd &mdd, mdd_node_source &mdd_node_source) {
-    auto *current_pointer = std::bit_cast<std::byte *>(&shared_object->flat_levels);
+node *create_root_node(const instance &instance,
+                       const bool forward,
+                       mdd_node_source &mdd_node_source,
+                       const solver_context &context) {
+    const auto root_node = mdd_node_source.new_node();
+    root_node->is_active = true;
+    auto &root_match = forward ? instance.graph->matches.front() : instance.graph->reverse_matches.front();
+    root_node->associated_match = &root_match;
+    root_node->character = root_match.character;
+    root_node->position_1 = root_match.extension->position_1;
+    root_node->position_2 = root_match.extension->position_2;
+    root_node->characters_on_paths_to_root = Character_set();
+    root_node->characters_on_all_paths_to_root = Character_set();
+    root_node->characters_on_paths_to_some_sink = root_match.extension->available_characters;
+    root_node->characters_on_all_paths_to_lower_bound_levels = Character_set();
+    root_node->upper_bound_down = context.upper_bound;
+    return root_node;
+}
 
-    auto static valid_matches_sets = std::vector<absl::flat_hash_set<void *> >(mdd.levels.size());
+void prune_by_flat_mdd(shared_object *shared_object,
+                       const mdd &mdd,
+                       mdd_node_source &mdd_node_source,
+                       scratch_space &scratch) {
+    auto &valid_matches_sets = scratch.valid_matches_sets;
     valid_matches_sets.resize(mdd.levels.size());
     for (auto &valid_matches: valid_matches_sets) {
         valid_matches.clear();
     }
 
-    static auto valid_edges_sets =
-            std::vector<absl::flat_hash_set<std::pair<void *, void*> > >(mdd.levels.size());
+    auto &valid_edges_sets = scratch.valid_edges_sets;
     valid_edges_sets.resize(mdd.levels.size());
     for (auto &valid_edges: valid_edges_sets) {
         valid_edges.clear();
     }
 
+    const auto *flat_levels = shared_object->levels();
+    const auto *flat_nodes = shared_object->nodes();
+    const auto *flat_edges = shared_object->edges();
     for (size_t level_index = 0; level_index < shared_object->num_levels; ++level_index) {
         auto &current_level_valid_matches = valid_matches_sets.at(level_index);
         auto &current_level_valid_edges = valid_edges_sets.at(level_index);
-        const auto *flat_level = std::bit_cast<struct flat_level *>(current_pointer);
-        current_pointer += sizeof(struct flat_level);
-
-        for (size_t node_index = 0; node_index < flat_level->num_nodes; ++node_index) {
-            auto flat_node = std::bit_cast<struct flat_node *>(current_pointer);
-            auto *match = std::bit_cast<rflcs_graph::match *>(flat_node->match_ptr);
-            if (flat_node->is_active) {
-                current_level_valid_matches.insert(match);
+        const auto &flat_level = flat_levels[level_index];
+        for (auto node_index = flat_level.first_node;
+             node_index < flat_level.first_node + flat_level.num_nodes;
+             ++node_index) {
+            const auto &flat_node = flat_nodes[node_index];
+            if (shared_object->is_node_active(node_index)) {
+                current_level_valid_matches.insert(flat_node.match_id);
             }
-            current_pointer += sizeof(struct flat_node);
-
-            for (size_t edge_index = 0; edge_index < flat_node->num_edges_out; ++edge_index) {
-                if (auto flat_edge = std::bit_cast<struct flat_edge *>(current_pointer); flat_edge->is_active) {
-                    auto *to = std::bit_cast<rflcs_graph::match *>(flat_edge->edge_node->match_ptr);
-                    current_level_valid_edges.emplace(match, to);
+            for (auto edge_index = flat_node.first_edge;
+                 edge_index < flat_node.first_edge + flat_node.num_edges_out;
+                 ++edge_index) {
+                if (shared_object->is_edge_active(edge_index)) {
+                    current_level_valid_edges.insert(match_id_pair_to_edge_long_encoding(
+                        flat_node.match_id,
+                        flat_nodes[flat_edges[edge_index].node_index].match_id));
                 }
-                current_pointer += sizeof(flat_edge);
             }
         }
     }
@@ -133,17 +154,66 @@ void prune_by_flat_mdd(shared_object *shared_object, const mdd &mdd, mdd_node_so
     for (const auto &level: mdd.levels) {
         const auto &current_valid_matches = valid_matches_sets.at(level->depth);
         const auto &current_valid_edges = valid_edges_sets.at(level->depth);
-        for (std::vector nodes(level->nodes.begin(), level->nodes.end()); const auto node: nodes) {
-            if (!current_valid_matches.contains(node->associated_match)) {
-                std::erase(level->nodes, node);
+        level->remove_nodes_if([&](node *node) {
+            const auto *match = static_cast<rflcs_graph::match *>(node->associated_match);
+            if (!current_valid_matches.contains(match->extension->match_id)) {
                 mdd_node_source.clear_node(node);
-            } else {
-                for (std::vector succs(node->edges_out.begin(), node->edges_out.end()); const auto succ: succs) {
-                    if (!current_valid_edges.contains({node->associated_match, succ->associated_match})) {
-                        node->unlink_pred_from_succ(succ);
-                    }
+                return true;
+            }
+            for (auto out_index = node->edges_out.size(); out_index-- > 0;) {
+                if (!current_valid_edges.contains(match_pair_to_edge_long_encoding(
+                    match, static_cast<rflcs_graph::match *>(node->edges_out[out_index]->associated_match)))) {
+                    node->unlink_out_edge(out_index);
                 }
             }
+            return false;
+        });
+    }
+}
+
+void prune_by_flat_deltas(std::vector<flat_delta> &deltas,
+                          const std::size_t num_levels,
+                          const mdd &mdd,
+                          mdd_node_source &mdd_node_source,
+                          scratch_space &scratch) {
+    for (auto level_index = num_levels; level_index < mdd.levels.size(); ++level_index) {
+        mdd.levels[level_index]->remove_nodes_if([&](node *node) {
+            mdd_node_source.clear_node(node);
+            return true;
+        });
+    }
+
+    auto &removed_matches = scratch.removed_matches;
+    auto &removed_edges = scratch.removed_edges;
+    std::ranges::sort(deltas, {}, &flat_delta::depth);
+    for (auto first_delta = deltas.begin(); first_delta != deltas.end();) {
+        const auto depth = first_delta->depth;
+        removed_matches.clear();
+        removed_edges.clear();
+        for (; first_delta != deltas.end() && first_delta->depth == depth; ++first_delta) {
+            if (first_delta->succ_match_id == NO_SUCC_MATCH_ID) {
+                removed_matches.insert(first_delta->match_id);
+            } else {
+                removed_edges.insert(match_id_pair_to_edge_long_encoding(first_delta->match_id,
+                                                                         first_delta->succ_match_id));
+            }
         }
+        if (static_cast<std::size_t>(depth) >= std::min(num_levels, mdd.levels.size())) {
+            continue;
+        }
+        mdd.levels[depth]->remove_nodes_if([&](node *node) {
+            const auto *match = static_cast<rflcs_graph::match *>(node->associated_match);
+            if (removed_matches.contains(match->extension->match_id)) {
+                mdd_node_source.clear_node(node);
+                return true;
+            }
+            for (auto out_index = node->edges_out.size(); !removed_edges.empty() && out_index-- > 0;) {
+                if (removed_edges.contains(match_pair_to_edge_long_encoding(
+                    match, static_cast<rflcs_graph::match *>(node->edges_out[out_index]->associated_match)))) {
+                    node->unlink_out_edge(out_index);
+                }
+            }
+            return false;
+        });
     }
 }
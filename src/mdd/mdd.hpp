@@ -1,12 +1,12 @@
 #pragma once
 #include "mdd_node_source.hpp"
 #include "mdd_levels.hpp"
-#include "absl/container/flat_hash_map.h"
 
 #include <memory>
 
 struct mdd {
     levels_type levels;
+    bool is_relaxed = false; // nodes of different states were merged, so some paths may repeat a character
 
     void deconstruct(mdd_node_source &mdd_node_source) const {
         for (const auto &level: levels) {
@@ -19,27 +19,44 @@ struct mdd {
     static std::unique_ptr<mdd> copy_mdd(const mdd &original_mdd, mdd_node_source &mdd_node_source);
 };
 
+/*
+ * The copy of a node takes the position of the original in the copied level, so the relatives of a copy are found
+ * through the level positions of the original relatives. The edge lists keep their order and their back-indices.
+ */
 inline std::unique_ptr<mdd> mdd::copy_mdd(const mdd &original_mdd, mdd_node_source &mdd_node_source) {
     auto copy_mdd = std::make_unique<mdd>();
     copy_mdd->levels = levels_type();
-    static auto original_node_map = absl::flat_hash_map<node*, node*>();
-    original_node_map.clear();
+    copy_mdd->is_relaxed = original_mdd.is_relaxed;
+    copy_mdd->levels.reserve(original_mdd.levels.size());
     for (const auto &original_level: original_mdd.levels) {
-        auto &[copy_nodes, copy_depth, _p] = *copy_mdd->levels.emplace_back(std::make_unique<level_type>());
-        copy_depth = original_level->depth;
-        copy_nodes.reserve(copy_nodes.size());
+        auto &copy_level = *copy_mdd->levels.emplace_back(std::make_unique<level_type>());
+        copy_level.depth = original_level->depth;
+        copy_level.nodes.reserve(original_level->nodes.size());
         for (const auto original_node: original_level->nodes) {
-            node *copy_node = mdd_node_source.get_copy_of_old_node_with_copy_helper(original_node);
-            original_node_map[original_node] = copy_node;
-            copy_nodes.push_back(copy_node);
-            for (const auto original_pred: original_node->edges_in) {
-                original_node_map[original_pred]->link_pred_to_succ(copy_node);
-                original_node_map[original_pred]->needs_update_from_succ = false;
+            copy_level.add_node(mdd_node_source.get_copy_of_old_node_with_copy_helper(original_node));
+        }
+    }
+
+    // edges only connect consecutive levels
+    for (std::size_t level_index = 0; level_index < original_mdd.levels.size(); ++level_index) {
+        const auto &original_nodes = original_mdd.levels[level_index]->nodes;
+        const auto &copy_nodes = copy_mdd->levels[level_index]->nodes;
+        const auto *copy_preds = level_index > 0 ? &copy_mdd->levels[level_index - 1]->nodes : nullptr;
+        const auto *copy_succs = level_index + 1 < copy_mdd->levels.size() ? &copy_mdd->levels[level_index + 1]->nodes : nullptr;
+        for (std::size_t position = 0; position < original_nodes.size(); ++position) {
+            const auto original_node = original_nodes[position];
+            const auto copy_node = copy_nodes[position];
+            copy_node->edges_out.resize(original_node->edges_out.size());
+            for (std::size_t out_index = 0; out_index < original_node->edges_out.size(); ++out_index) {
+                copy_node->edges_out[out_index] = (*copy_succs)[original_node->edges_out[out_index]->level_position];
             }
-            copy_node->needs_update_from_pred = false;
-            copy_node->needs_update_from_succ = false;
+            copy_node->edges_in.resize(original_node->edges_in.size());
+            for (std::size_t in_index = 0; in_index < original_node->edges_in.size(); ++in_index) {
+                copy_node->edges_in[in_index] = (*copy_preds)[original_node->edges_in[in_index]->level_position];
+            }
+            copy_node->edges_out_positions = original_node->edges_out_positions;
+            copy_node->edges_in_positions = original_node->edges_in_positions;
         }
     }
     return copy_mdd;
 }
-
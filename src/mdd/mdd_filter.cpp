@@ -1,107 +1,263 @@
 #include "header/mdd_filter.hpp"
 #include "header/domination_utils.hpp"
-#include "edge_utils.hpp"
 #include "../constants.hpp"
-#include "absl/container/flat_hash_set.h"
+#include "../worker_pool.hpp"
+#include "mdd_undo_log.hpp"
+#include "mdd_flat_writeback.hpp"
 
+#include <functional>
 #include <iomanip>
+#include <numeric>
 #include <ranges>
 
-bool update_nodes_and_prune(shared_object *shared_object, mdd &mdd, mdd_node_source &mdd_node_source);
+/*
+ * Within a level sweep a node update only reads the neighbouring level and writes the node itself,
+ * so the updates of a batch of dirty nodes run in parallel with the scratch space of their worker.
+ * Marking relatives, unlinking edges and pruning touch other nodes and are applied afterward in queue order,
+ * which keeps the result independent of the number of workers.
+ */
+struct node_update {
+    node *updated_node = nullptr;
+    relatives_to_notify relatives = relatives_to_notify();
+    std::size_t worker_index = 0;
+    std::size_t first_unlinked_edge = 0; // range in unlinked_out_edges of the worker scratch
+    std::size_t end_unlinked_edge = 0;
+    bool is_pruned = false;
+};
 
-bool update_node_from_succ(const level_type &level, node &node);
+constexpr std::size_t nodes_per_update_task = 64;
 
-bool update_node_from_pred(node &node, int depth);
+void filter_mdd_to_fixpoint(shared_object *shared_object,
+                            mdd &mdd,
+                            mdd_node_source &mdd_node_source,
+                            solver_context &context);
 
-bool filter_succ_edges_of_node(const level_type &level, node &node);
+bool update_nodes_and_prune(shared_object *shared_object,
+                            mdd &mdd,
+                            mdd_node_source &mdd_node_source,
+                            std::vector<node_update> &updates,
+                            solver_context &context);
 
-bool prune_node_from_level(level_type &level, node *node);
+bool sweep_level(level_type &level,
+                 bool is_from_pred,
+                 bool is_pruning,
+                 std::vector<node_update> &updates,
+                 solver_context &context);
+
+void compute_node_updates(const level_type &level,
+                          bool is_from_pred,
+                          bool is_pruning,
+                          std::vector<node_update> &updates,
+                          solver_context &context);
+
+void compute_node_update(const level_type &level,
+                         bool is_from_pred,
+                         bool is_pruning,
+                         int lower_bound,
+                         node_update &update,
+                         scratch_space &scratch);
+
+bool apply_node_update(level_type &level, const node_update &update, solver_context &context);
+
+relatives_to_notify update_node_from_succ(node &node, int depth, int lower_bound, scratch_space &scratch);
+
+relatives_to_notify update_node_from_pred(node &node, int depth, scratch_space &scratch);
+
+void filter_succ_edges_of_node(const level_type &level, node &node, int lower_bound, scratch_space &scratch);
+
+bool prune_node_from_level(const level_type &level, node &node, int lower_bound, scratch_space &scratch);
+
+void drop_levels(mdd &mdd, const std::function<bool(const level_type &)> &is_dropped);
 
 void clear_level(level_type &level, mdd_node_source &mdd_node_source);
 
-void filter_mdd(const instance &instance, mdd &mdd, mdd_node_source &mdd_node_source) {
-    if (temporaries::lower_bound >= temporaries::upper_bound) {
+bool dequeue_dirty_node(const level_type &level, const node &node, bool &is_queued);
+
+void filter_mdd(const instance &instance, mdd &mdd, mdd_node_source &mdd_node_source, solver_context &context) {
+    filter_mdd_to_fixpoint(instance.shared_object, mdd, mdd_node_source, context);
+}
+
+void filter_trial_mdd(mdd &mdd, mdd_node_source &mdd_node_source, solver_context &context) {
+    filter_mdd_to_fixpoint(nullptr, mdd, mdd_node_source, context);
+}
+
+void filter_mdd_to_fixpoint(shared_object *shared_object,
+                            mdd &mdd,
+                            mdd_node_source &mdd_node_source,
+                            solver_context &context) {
+    if (context.lower_bound >= context.upper_bound) {
         return;
     }
 
+    auto updates = std::vector<node_update>();
     auto is_still_running = true;
-    while (is_still_running) {
-        is_still_running = update_nodes_and_prune(instance.shared_object, mdd, mdd_node_source);
+    while (is_still_running && !context.stop_token.stop_requested()) {
+        is_still_running = update_nodes_and_prune(shared_object, mdd, mdd_node_source, updates, context);
     }
 }
 
-bool update_nodes_and_prune(shared_object *shared_object, mdd &mdd, mdd_node_source &mdd_node_source) {
+bool update_nodes_and_prune(shared_object *shared_object,
+                            mdd &mdd,
+                            mdd_node_source &mdd_node_source,
+                            std::vector<node_update> &updates,
+                            solver_context &context) {
     auto is_changed = false;
     auto is_still_changing = true;
 
-    while (is_still_changing && temporaries::lower_bound < temporaries::upper_bound) {
+    // a stop is only honored after the bounds of a full sweep are updated, so they hold for the partly filtered mdd
+    while (is_still_changing && context.lower_bound < context.upper_bound && !context.stop_token.stop_requested()) {
         is_still_changing = false;
 
         for (const auto &level: mdd.levels | std::views::drop(1)) {
-            for (const auto node: level->nodes) {
-                const auto needed_updates = node->needs_update_from_succ || node->needs_update_from_pred;
-                const auto is_updated_from_pred = update_node_from_pred(*node, level->depth);
-                is_still_changing |= is_updated_from_pred;
-                if (is_updated_from_pred) {
-                    is_still_changing |= filter_succ_edges_of_node(*level, *node);
-                }
-                if (needed_updates) {
-                    is_still_changing |= prune_node_from_level(*level, node);
-                }
-            }
+            is_still_changing |= sweep_level(*level, true, true, updates, context);
             clear_level(*level, mdd_node_source);
         }
 
         for (const auto &level: mdd.levels | std::views::reverse | std::views::take(mdd.levels.size() - 1)) {
-            for (const auto node: level->nodes) {
-                const auto needed_update_from_succ = node->needs_update_from_succ;
-                const auto needed_updates = node->needs_update_from_succ || node->needs_update_from_pred;
-                const auto is_updated_from_succ = update_node_from_succ(*level, *node);
-                is_still_changing |= is_updated_from_succ;
-                if (needed_update_from_succ) {
-                    is_still_changing |= filter_succ_edges_of_node(*level, *node);
-                }
-                if (needed_updates) {
-                    is_still_changing |= prune_node_from_level(*level, node);
-                }
-            }
+            is_still_changing |= sweep_level(*level, false, true, updates, context);
             clear_level(*level, mdd_node_source);
         }
-        for (const auto &root_level = mdd.levels.front(); const auto node: root_level->nodes) {
-            const bool needs_update_from_succ = node->needs_update_from_succ;
-            is_still_changing |= update_node_from_succ(*root_level, *node);
-            if (needs_update_from_succ) {
-                is_still_changing |= filter_succ_edges_of_node(*root_level, *node);
-            }
+
+        const auto &root_level = mdd.levels.front();
+        for (const auto node: root_level->dirty_nodes.from_pred) {
+            dequeue_dirty_node(*root_level, *node, node->is_queued_from_pred); // the root has no preds
         }
+        root_level->dirty_nodes.from_pred.clear();
+        is_still_changing |= sweep_level(*root_level, false, false, updates, context);
 
-        std::erase_if(mdd.levels, [](const std::unique_ptr<level_type> &level) { return level->nodes.empty(); });
+        drop_levels(mdd, [](const level_type &level) { return level.nodes.empty(); });
         int levels_depth = static_cast<int>(mdd.levels.size()) - 1;
-        temporaries::upper_bound = std::min(temporaries::upper_bound, levels_depth);
-        temporaries::upper_bound = std::min(temporaries::upper_bound,
+        context.upper_bound = std::min(context.upper_bound, levels_depth);
+        context.upper_bound = std::min(context.upper_bound,
                                             mdd.levels.front()->nodes.front()->upper_bound_down);
 
-        if (levels_depth > temporaries::upper_bound) {
-            for (const auto &level: mdd.levels | std::views::drop(temporaries::upper_bound + 1)) {
+        if (levels_depth > context.upper_bound) {
+            for (const auto &level: mdd.levels | std::views::drop(context.upper_bound + 1)) {
                 for (const auto node: level->nodes) {
                     mdd_node_source.clear_node(node);
                 }
             }
-            mdd.levels.resize(temporaries::upper_bound + 1);
+            const int max_depth = mdd.levels[context.upper_bound]->depth;
+            drop_levels(mdd, [max_depth](const level_type &level) { return level.depth > max_depth; });
         }
 
         if (shared_object != nullptr) {
-            shared_object->upper_bound = temporaries::upper_bound;
+            shared_object->upper_bound = context.upper_bound;
         }
         is_changed |= is_still_changing;
     }
     return is_changed;
 }
 
+// entries queued while a batch is applied, e.g. of nodes which unlinked an out edge, are handled by the next batch
+bool sweep_level(level_type &level,
+                 const bool is_from_pred,
+                 const bool is_pruning,
+                 std::vector<node_update> &updates,
+                 solver_context &context) {
+    auto is_changed = false;
+    auto &dirty_nodes = is_from_pred ? level.dirty_nodes.from_pred : level.dirty_nodes.from_succ;
+    std::size_t dirty_index = 0;
+    while (dirty_index < dirty_nodes.size()) {
+        updates.clear();
+        for (; dirty_index < dirty_nodes.size(); ++dirty_index) {
+            const auto node = dirty_nodes[dirty_index];
+            if (dequeue_dirty_node(level, *node, is_from_pred ? node->is_queued_from_pred : node->is_queued_from_succ)) {
+                updates.push_back(node_update{.updated_node = node});
+            }
+        }
+        compute_node_updates(level, is_from_pred, is_pruning, updates, context);
+        for (const auto &update: updates) {
+            is_changed |= apply_node_update(level, update, context);
+        }
+    }
+    dirty_nodes.clear();
+    return is_changed;
+}
+
+void compute_node_updates(const level_type &level,
+                          const bool is_from_pred,
+                          const bool is_pruning,
+                          std::vector<node_update> &updates,
+                          solver_context &context) {
+    auto &worker_pool = get_worker_pool();
+    // a trial records the updated nodes in its undo log, so it updates them on the calling thread
+    const auto number_of_tasks = level.dirty_nodes.undo_log == nullptr
+                                     ? (updates.size() + nodes_per_update_task - 1) / nodes_per_update_task
+                                     : 1;
+    if (number_of_tasks > 1 && context.worker_scratch.size() + 1 < worker_pool.number_of_workers()) {
+        context.worker_scratch.resize(worker_pool.number_of_workers() - 1);
+    }
+    context.scratch.unlinked_out_edges.clear();
+    for (auto &scratch: context.worker_scratch) {
+        scratch.unlinked_out_edges.clear();
+    }
+
+    const int lower_bound = context.lower_bound;
+    worker_pool.run(number_of_tasks, [&](const std::size_t worker_index, const std::size_t task_index) {
+        auto &scratch = context.scratch_of_worker(worker_index);
+        const auto begin_index = task_index * nodes_per_update_task;
+        const auto end_index = number_of_tasks == 1 ? updates.size() : std::min(updates.size(), begin_index + nodes_per_update_task);
+        for (auto update_index = begin_index; update_index < end_index; ++update_index) {
+            updates[update_index].worker_index = worker_index;
+            compute_node_update(level, is_from_pred, is_pruning, lower_bound, updates[update_index], scratch);
+        }
+    });
+}
+
+inline void compute_node_update(const level_type &level,
+                                const bool is_from_pred,
+                                const bool is_pruning,
+                                const int lower_bound,
+                                node_update &update,
+                                scratch_space &scratch) {
+    auto &node = *update.updated_node;
+    const auto needed_update_from_succ = node.needs_update_from_succ;
+    const auto needed_updates = node.needs_update_from_succ || node.needs_update_from_pred;
+    update.first_unlinked_edge = scratch.unlinked_out_edges.size();
+    if (is_from_pred) {
+        update.relatives = update_node_from_pred(node, level.depth, scratch);
+        if (update.relatives.any()) {
+            filter_succ_edges_of_node(level, node, lower_bound, scratch);
+        }
+    } else {
+        update.relatives = update_node_from_succ(node, level.depth, lower_bound, scratch);
+        if (needed_update_from_succ) {
+            filter_succ_edges_of_node(level, node, lower_bound, scratch);
+        }
+    }
+    update.end_unlinked_edge = scratch.unlinked_out_edges.size();
+    update.is_pruned = is_pruning && needed_updates && prune_node_from_level(level, node, lower_bound, scratch);
+}
+
+inline bool apply_node_update(level_type &level, const node_update &update, solver_context &context) {
+    update.updated_node->notify_of_update(update.relatives);
+    const auto &unlinked_out_edges = context.scratch_of_worker(update.worker_index).unlinked_out_edges;
+    for (auto unlinked_index = update.first_unlinked_edge; unlinked_index < update.end_unlinked_edge; ++unlinked_index) {
+        update.updated_node->unlink_out_edge(unlinked_out_edges[unlinked_index]);
+    }
+    if (update.is_pruned) {
+        level.needs_pruning = true;
+    }
+    return update.relatives.any() || update.first_unlinked_edge < update.end_unlinked_edge || update.is_pruned;
+}
+
+// the undo log of a running trial keeps the dropped levels alive
+void drop_levels(mdd &mdd, const std::function<bool(const level_type &)> &is_dropped) {
+    for (auto &level: mdd.levels) {
+        if (is_dropped(*level) && level->dirty_nodes.undo_log != nullptr) {
+            level->dirty_nodes.undo_log->keep_dropped_level(std::move(level));
+        }
+    }
+    std::erase_if(mdd.levels, [&is_dropped](const std::unique_ptr<level_type> &level) {
+        return level == nullptr || is_dropped(*level);
+    });
+}
+
 void clear_level(level_type &level, mdd_node_source &mdd_node_source) {
     if (level.needs_pruning) {
         level.needs_pruning = false;
-        std::erase_if(level.nodes, [&mdd_node_source](node *node) {
+        level.remove_nodes_if([&mdd_node_source](node *node) {
             if (node->is_active) {
                 return false;
             }
@@ -111,72 +267,86 @@ void clear_level(level_type &level, mdd_node_source &mdd_node_source) {
     }
 }
 
-inline bool update_node_from_succ(const level_type &level, node &node) {
-    if (!node.needs_update_from_succ) {
+// false for stale entries, i.e. of nodes which were visited already or left the level since
+inline bool dequeue_dirty_node(const level_type &level, const node &node, bool &is_queued) {
+    if (!is_queued || node.dirty_nodes != &level.dirty_nodes) {
         return false;
     }
-    return node.update_from_succs(level.depth, temporaries::lower_bound);
+    is_queued = false;
+    return true;
+}
+
+inline relatives_to_notify update_node_from_succ(node &node, const int depth, const int lower_bound, scratch_space &scratch) {
+    if (!node.needs_update_from_succ) {
+        return relatives_to_notify();
+    }
+    return node.update_from_succs(depth, lower_bound, scratch);
 }
 
-inline bool update_node_from_pred(node &node, const int depth) {
+inline relatives_to_notify update_node_from_pred(node &node, const int depth, scratch_space &scratch) {
     if (!node.needs_update_from_pred || node.edges_in.empty()) {
-        return false;
+        return relatives_to_notify();
     }
-    return node.update_from_preds(depth);
+    return node.update_from_preds(depth, scratch);
 }
 
-inline bool prune_node_from_level(level_type &level, node *node) {
-    const bool no_incoming_edges = node->edges_in.empty();
-    const bool is_insufficient_upper_bound = level.depth + node->upper_bound_down <= temporaries::lower_bound;
-    temporaries::temp_character_set_1 = node->characters_on_paths_to_root;
-    temporaries::temp_character_set_1 |= node->characters_on_paths_to_some_sink;
-    temporaries::temp_character_set_2 = node->characters_on_all_paths_to_root;
-    temporaries::temp_character_set_2 &= node->characters_on_all_paths_to_lower_bound_levels;
+// deactivates the node, the level drops it in clear_level
+inline bool prune_node_from_level(const level_type &level, node &node, const int lower_bound, scratch_space &scratch) {
+    const bool no_incoming_edges = node.edges_in.empty();
+    const bool is_insufficient_upper_bound = level.depth + node.upper_bound_down <= lower_bound;
+    scratch.temp_character_set_1 = node.characters_on_paths_to_root;
+    scratch.temp_character_set_1 |= node.characters_on_paths_to_some_sink;
+    scratch.temp_character_set_2 = node.characters_on_all_paths_to_root;
+    scratch.temp_character_set_2 &= node.characters_on_all_paths_to_lower_bound_levels;
     if (no_incoming_edges
         || is_insufficient_upper_bound
-        || static_cast<int>(temporaries::temp_character_set_1.count()) <= temporaries::lower_bound
-        || temporaries::temp_character_set_2.any()
+        || static_cast<int>(scratch.temp_character_set_1.count()) <= lower_bound
+        || scratch.temp_character_set_2.any()
     ) {
-        level.needs_pruning = true;
-        node->is_active = false;
+        node.record_for_undo();
+        node.is_active = false;
         return true;
     }
     return false;
 }
 
-inline bool filter_succ_edges_of_node(const level_type &level, node &node) {
-    bool filtered_edge = false;
+// records the out edges to unlink in the scratch, they are unlinked with the node update
+inline void filter_succ_edges_of_node(const level_type &level, node &node, const int lower_bound, scratch_space &scratch) {
     int max_position_2 = std::numeric_limits<int>::max();
-    static auto succ_nodes = std::vector<struct node *>(constants::alphabet_size);
-    std::ranges::copy(node.edges_out, succ_nodes.begin());
-    std::ranges::sort(succ_nodes.begin(), succ_nodes.begin() + node.edges_out.size(),
-                          [](const auto node1, const auto node2) {
-                              return node1->position_1 < node2->position_1;
+    auto &succ_indices = scratch.succ_indices;
+    auto &is_unlinking = scratch.is_unlinking;
+    const auto number_of_succs = node.edges_out.size();
+    std::iota(succ_indices.begin(), succ_indices.begin() + number_of_succs, 0);
+    std::fill_n(is_unlinking.begin(), number_of_succs, false);
+    std::ranges::sort(succ_indices.begin(), succ_indices.begin() + number_of_succs,
+                          [&node](const auto index1, const auto index2) {
+                              return node.edges_out[index1]->position_1 < node.edges_out[index2]->position_1;
                           });
     int min_positions_2_size = 0;
-    static auto min_positions_2 = std::vector<int>(constants::alphabet_size);
+    auto &min_positions_2 = scratch.min_positions_2;
     const int domination_threshold = level.depth - static_cast<int>(node.characters_on_all_paths_to_root.count()) + 1;
-    for (const auto succ: succ_nodes | std::views::take(node.edges_out.size())) {
-        temporaries::temp_character_set_1 = node.characters_on_paths_to_root;
-        temporaries::temp_character_set_1 |= succ->characters_on_paths_to_some_sink;
-        temporaries::temp_character_set_1.set(succ->character);
+    for (const auto succ_index: succ_indices | std::views::take(number_of_succs)) {
+        const auto succ = node.edges_out[succ_index];
+        scratch.temp_character_set_1 = node.characters_on_paths_to_root;
+        scratch.temp_character_set_1 |= succ->characters_on_paths_to_some_sink;
+        scratch.temp_character_set_1.set(succ->character);
         const bool combined_characters_not_sufficient =
-                static_cast<int>(temporaries::temp_character_set_1.count()) <= temporaries::lower_bound;
-        temporaries::temp_character_set_2 = node.characters_on_all_paths_to_root;
-        temporaries::temp_character_set_2 &= succ->characters_on_all_paths_to_lower_bound_levels;
-        const bool repetition_free_conflict = temporaries::temp_character_set_2.any();
-        temporaries::temp_character_set_1 = succ->characters_on_paths_to_some_sink;
-        temporaries::temp_character_set_1.set(succ->character);
-        temporaries::temp_character_set_1 &= ~node.characters_on_all_paths_to_root;
+                static_cast<int>(scratch.temp_character_set_1.count()) <= lower_bound;
+        scratch.temp_character_set_2 = node.characters_on_all_paths_to_root;
+        scratch.temp_character_set_2 &= succ->characters_on_all_paths_to_lower_bound_levels;
+        const bool repetition_free_conflict = scratch.temp_character_set_2.any();
+        scratch.temp_character_set_1 = succ->characters_on_paths_to_some_sink;
+        scratch.temp_character_set_1.set(succ->character);
+        scratch.temp_character_set_1 &= ~node.characters_on_all_paths_to_root;
         const bool too_many_characters_already_taken =
-                level.depth + static_cast<int>(temporaries::temp_character_set_1.count()) <= temporaries::lower_bound;
+                level.depth + static_cast<int>(scratch.temp_character_set_1.count()) <= lower_bound;
         const bool is_dominated = dominated_by_some_available_but_unused_character(
             succ->position_2,
             domination_threshold,
             min_positions_2,
             min_positions_2_size);
         if (!node.characters_on_paths_to_some_sink.test(succ->character)
-            || level.depth + 1 + succ->upper_bound_down <= temporaries::lower_bound
+            || level.depth + 1 + succ->upper_bound_down <= lower_bound
             || combined_characters_not_sufficient
             || repetition_free_conflict
             || succ->position_2 > max_position_2
@@ -184,9 +354,7 @@ inline bool filter_succ_edges_of_node(const level_type &level, node &node) {
             || too_many_characters_already_taken
             || node.characters_on_all_paths_to_root.test(succ->character)
         ) {
-            node.unlink_pred_from_succ(succ);
-            node.needs_update_from_succ = true;
-            filtered_edge = true;
+            is_unlinking[succ_index] = true;
         } else {
             if (!node.characters_on_paths_to_root.test(succ->character)) {
                 max_position_2 = std::min(max_position_2, succ->position_2);
@@ -194,68 +362,34 @@ inline bool filter_succ_edges_of_node(const level_type &level, node &node) {
             add_position_2_to_maybe_min_pos_2(min_positions_2, succ->position_2, min_positions_2_size, domination_threshold);
         }
     }
-    return filtered_edge;
-}
-
-void filter_flat_mdd(const instance &instance, const mdd &mdd, const bool is_reporting) {
-    instance.shared_object->num_levels = mdd.levels.size();
-    auto static valid_matches = absl::flat_hash_set<void *>();
-    valid_matches.clear();
-    auto static valid_edges = absl::flat_hash_set<long>();
-    valid_edges.clear();
-    auto *current_pointer = std::bit_cast<std::byte *>(instance.shared_object);
-    current_pointer += sizeof(shared_object);
-    for (size_t level_index = 0; level_index < instance.shared_object->num_levels; ++level_index) {
-        auto static current_level_valid_matches = absl::flat_hash_set<void *>();
-        current_level_valid_matches.clear();
-        auto static current_level_valid_edges = absl::flat_hash_set<long>();
-        current_level_valid_edges.clear();
-
-        for (const auto node: mdd.levels.at(level_index)->nodes) {
-            current_level_valid_matches.emplace(node->associated_match);
-            valid_matches.emplace(node->associated_match);
-            for (const auto to: node->edges_out) {
-                long pair_long_encoding = match_pair_to_edge_long_encoding(
-                    static_cast<rflcs_graph::match *>(node->associated_match),
-                    static_cast<rflcs_graph::match *>(to->associated_match)
-                );
-                current_level_valid_edges.emplace(pair_long_encoding);
-                valid_edges.emplace(pair_long_encoding);
-            }
-        }
-
-        const auto *flat_level = std::bit_cast<struct flat_level *>(current_pointer);
-        current_pointer += sizeof(struct flat_level);
-
-        for (size_t node_index = 0; node_index < flat_level->num_nodes; ++node_index) {
-            auto flat_node = std::bit_cast<struct flat_node *>(current_pointer);
-            flat_node->is_active &=
-                    current_level_valid_matches.contains(static_cast<rflcs_graph::match *>(flat_node->match_ptr));
-            current_pointer += sizeof(struct flat_node);
-            for (size_t edge_index = 0; edge_index < flat_node->num_edges_out; ++edge_index) {
-                auto flat_edge = std::bit_cast<struct flat_edge *>(current_pointer);
-                flat_edge->is_active &= current_level_valid_edges.contains(
-                    match_pair_to_edge_long_encoding(
-                        static_cast<const rflcs_graph::match *>(flat_node->match_ptr),
-                        static_cast<const rflcs_graph::match *>(flat_edge->edge_node->match_ptr))
-                );
-                current_pointer += sizeof(struct flat_edge);
-            }
+    // backwards, so the edges swapped in by an unlink are already visited
+    for (auto out_index = number_of_succs; out_index-- > 0;) {
+        if (is_unlinking[out_index]) {
+            scratch.unlinked_out_edges.push_back(static_cast<unsigned int>(out_index));
         }
     }
+}
 
-    instance.shared_object->active_match_count = static_cast<int>(valid_matches.size()) - 1;
+void filter_flat_mdd(const instance &instance,
+                     const mdd &mdd,
+                     mdd_flat_writeback &flat_writeback,
+                     const bool is_reporting) {
+    auto &shared_object = *instance.shared_object;
+    shared_object.num_levels = mdd.levels.size();
+    flat_writeback.write_back(true);
+    shared_object.active_match_count = flat_writeback.get_number_of_matches_in_mdd() - 1;
     if (is_reporting) {
         const std::chrono::duration<double> seconds_since_start = std::chrono::system_clock::now() - instance.start;
         std::cout << "Elapsed time: "
                 << std::fixed << std::setprecision(2)
                 << seconds_since_start.count() << "s."
-                << " Reduced to " << instance.shared_object->active_match_count << " matches / "
-                << 100 - 100 * static_cast<double>(instance.shared_object->active_match_count) /
+                << " Reduced to " << shared_object.active_match_count << " matches / "
+                << 100 - 100 * static_cast<double>(shared_object.active_match_count) /
                 static_cast<double>(instance.graph->matches.size() - 2) << "%."
-                << " Remaining edges: " << valid_edges.size() << "."
-                << " Upper bound: " << instance.shared_object->upper_bound << "."
-                << " Refined Characters: " << instance.shared_object->number_of_refined_characters << "."
+                << " Remaining edges: " << flat_writeback.get_number_of_edges_in_mdd() << "."
+                << " Upper bound: " << shared_object.upper_bound << "."
+                << " Refined Characters: " << shared_object.number_of_refined_characters << "."
                 << std::endl;
     }
 }
+
@@ -0,0 +1,250 @@
+#include "mdd_flat_writeback.hpp"
+#include "../instance.hpp"
+#include "edge_utils.hpp"
+#include "absl/container/flat_hash_map.h"
+
+#include <algorithm>
+
+int match_id_of(const node &node);
+
+void write_back_node_joining(mdd_flat_writeback &flat_writeback, const node &node) {
+    flat_writeback.node_joining(node);
+}
+
+void write_back_node_leaving(mdd_flat_writeback &flat_writeback, const node &node) {
+    flat_writeback.node_leaving(node);
+}
+
+void write_back_linked_edge(mdd_flat_writeback &flat_writeback, const node &pred, const node &succ) {
+    flat_writeback.edge_linked(pred, succ);
+}
+
+void write_back_unlinked_edge(mdd_flat_writeback &flat_writeback, const node &pred, const node &succ) {
+    flat_writeback.edge_unlinked(pred, succ);
+}
+
+void mdd_flat_writeback::attach(const mdd &mdd, const instance &instance) {
+    flat_mdd = instance.shared_object;
+    const auto &layout = flat_mdd->layout;
+    const auto *flat_levels = flat_mdd->levels();
+    const auto *flat_nodes = flat_mdd->nodes();
+    const auto *flat_edges = flat_mdd->edges();
+    representative_nodes.assign(layout.num_nodes, NO_FLAT_NODE);
+    next_same_match_nodes.assign(layout.num_nodes, NO_FLAT_NODE);
+    next_same_match_edges.assign(layout.num_edges, NO_FLAT_NODE);
+    node_counts.assign(layout.num_nodes, 0);
+    edge_counts.assign(layout.num_edges, 0);
+    released_nodes.clear();
+    released_edges.clear();
+    match_counts.assign(instance.graph->matches.size() + instance.graph->reverse_matches.size(), 0);
+    number_of_matches_in_mdd = 0;
+    edge_pair_counts.clear();
+    number_of_edges_in_mdd = 0;
+
+    // the last flat node of each match in the level, which the next one with the same match is chained to
+    auto last_same_match_nodes = absl::flat_hash_map<int, std::uint32_t>();
+    for (std::size_t level_index = 0; level_index < layout.level_capacity; ++level_index) {
+        const auto &flat_level = flat_levels[level_index];
+        last_same_match_nodes.clear();
+        for (auto node_index = flat_level.first_node;
+             node_index < flat_level.first_node + flat_level.num_nodes;
+             ++node_index) {
+            if (const auto [last_same_match_node, is_first] =
+                        last_same_match_nodes.try_emplace(flat_nodes[node_index].match_id, node_index);
+                is_first) {
+                representative_nodes[node_index] = node_index;
+            } else {
+                representative_nodes[node_index] = representative_nodes[last_same_match_node->second];
+                next_same_match_nodes[last_same_match_node->second] = node_index;
+                last_same_match_node->second = node_index;
+            }
+        }
+        if (level_index < mdd.levels.size()) {
+            auto &level = *mdd.levels[level_index];
+            level.dirty_nodes.flat_writeback = this;
+            for (const auto node: level.nodes) {
+                const auto last_same_match_node = last_same_match_nodes.find(match_id_of(*node));
+                node->flat_node_index = last_same_match_node == last_same_match_nodes.end()
+                                            ? NO_FLAT_NODE
+                                            : representative_nodes[last_same_match_node->second];
+            }
+        }
+    }
+    for (std::size_t level_index = layout.level_capacity; level_index < mdd.levels.size(); ++level_index) {
+        mdd.levels[level_index]->dirty_nodes.flat_writeback = this;
+        for (const auto node: mdd.levels[level_index]->nodes) {
+            node->flat_node_index = NO_FLAT_NODE;
+        }
+    }
+
+    // the edges of all flat nodes of a representative, sorted by the representative of their successor
+    first_representative_edges.clear();
+    representative_edge_succs.clear();
+    representative_edges.clear();
+    auto edges_by_succ = std::vector<std::pair<std::uint32_t, std::uint32_t> >();
+    for (std::uint32_t node_index = 0; node_index < layout.num_nodes; ++node_index) {
+        first_representative_edges.push_back(static_cast<std::uint32_t>(representative_edges.size()));
+        if (representative_nodes[node_index] != node_index) {
+            continue;
+        }
+        edges_by_succ.clear();
+        for (auto same_match_node = node_index;
+             same_match_node != NO_FLAT_NODE;
+             same_match_node = next_same_match_nodes[same_match_node]) {
+            const auto &flat_node = flat_nodes[same_match_node];
+            for (auto edge_index = flat_node.first_edge;
+                 edge_index < flat_node.first_edge + flat_node.num_edges_out;
+                 ++edge_index) {
+                edges_by_succ.emplace_back(representative_nodes[flat_edges[edge_index].node_index], edge_index);
+            }
+        }
+        std::ranges::sort(edges_by_succ);
+        for (std::size_t pair_index = 0; pair_index < edges_by_succ.size(); ++pair_index) {
+            const auto &[succ, edge_index] = edges_by_succ[pair_index];
+            if (pair_index > 0 && edges_by_succ[pair_index - 1].first == succ) {
+                next_same_match_edges[edges_by_succ[pair_index - 1].second] = edge_index;
+            } else {
+                representative_edge_succs.push_back(succ);
+                representative_edges.push_back(edge_index);
+            }
+        }
+    }
+    first_representative_edges.push_back(static_cast<std::uint32_t>(representative_edges.size()));
+
+    for (const auto &level: mdd.levels) {
+        for (const auto node: level->nodes) {
+            node_joining(*node);
+            for (const auto succ: node->edges_out) {
+                edge_linked(*node, *succ);
+            }
+        }
+    }
+
+    // flat entries without a counterpart are cleared by the next write back, as long as their level is in use
+    const auto num_levels = std::min(mdd.levels.size(), layout.level_capacity);
+    const auto node_end = num_levels < layout.level_capacity ? flat_levels[num_levels].first_node : layout.num_nodes;
+    for (std::uint32_t node_index = 0; node_index < node_end; ++node_index) {
+        if (representative_nodes[node_index] != node_index) {
+            continue;
+        }
+        if (node_counts[node_index] == 0) {
+            released_nodes.push_back(node_index);
+        }
+        for (auto edge_position = first_representative_edges[node_index];
+             edge_position < first_representative_edges[node_index + 1];
+             ++edge_position) {
+            if (edge_counts[representative_edges[edge_position]] == 0) {
+                released_edges.emplace_back(node_index, representative_edges[edge_position]);
+            }
+        }
+    }
+}
+
+void mdd_flat_writeback::detach(const mdd &mdd) {
+    for (const auto &level: mdd.levels) {
+        level->dirty_nodes.flat_writeback = nullptr;
+    }
+}
+
+void mdd_flat_writeback::write_back(const bool is_logging) {
+    const auto *flat_nodes = flat_mdd->nodes();
+    const auto *flat_edges = flat_mdd->edges();
+    for (const auto released_node: released_nodes) {
+        if (node_counts[released_node] == 0 && flat_mdd->is_node_active(released_node)) {
+            if (is_logging) {
+                flat_mdd->delta_log.append(flat_delta{
+                    .depth = depth_of(released_node),
+                    .match_id = flat_nodes[released_node].match_id,
+                    .succ_match_id = NO_SUCC_MATCH_ID
+                });
+            }
+            for (auto node_index = released_node; node_index != NO_FLAT_NODE;
+                 node_index = next_same_match_nodes[node_index]) {
+                flat_mdd->deactivate_node(node_index);
+            }
+        }
+    }
+    released_nodes.clear();
+    for (const auto &[pred_node, released_edge]: released_edges) {
+        if (edge_counts[released_edge] == 0 && flat_mdd->is_edge_active(released_edge)) {
+            if (is_logging) {
+                flat_mdd->delta_log.append(flat_delta{
+                    .depth = depth_of(pred_node),
+                    .match_id = flat_nodes[pred_node].match_id,
+                    .succ_match_id = flat_nodes[flat_edges[released_edge].node_index].match_id
+                });
+            }
+            for (auto edge_index = released_edge; edge_index != NO_FLAT_NODE;
+                 edge_index = next_same_match_edges[edge_index]) {
+                flat_mdd->deactivate_edge(edge_index);
+            }
+        }
+    }
+    released_edges.clear();
+}
+
+void mdd_flat_writeback::node_joining(const node &node) {
+    if (match_counts[match_id_of(node)]++ == 0) {
+        ++number_of_matches_in_mdd;
+    }
+    if (node.flat_node_index != NO_FLAT_NODE) {
+        ++node_counts[node.flat_node_index];
+    }
+}
+
+void mdd_flat_writeback::node_leaving(const node &node) {
+    if (--match_counts[match_id_of(node)] == 0) {
+        --number_of_matches_in_mdd;
+    }
+    if (node.flat_node_index != NO_FLAT_NODE && --node_counts[node.flat_node_index] == 0) {
+        released_nodes.push_back(node.flat_node_index);
+    }
+}
+
+void mdd_flat_writeback::edge_linked(const node &pred, const node &succ) {
+    if (edge_pair_counts[match_id_pair_to_edge_long_encoding(match_id_of(pred), match_id_of(succ))]++ == 0) {
+        ++number_of_edges_in_mdd;
+    }
+    if (const auto edge_index = find_edge(pred, succ); edge_index != NO_FLAT_NODE) {
+        ++edge_counts[edge_index];
+    }
+}
+
+void mdd_flat_writeback::edge_unlinked(const node &pred, const node &succ) {
+    if (const auto edge_pair = edge_pair_counts.find(
+            match_id_pair_to_edge_long_encoding(match_id_of(pred), match_id_of(succ)));
+        edge_pair != edge_pair_counts.end() && --edge_pair->second == 0) {
+        edge_pair_counts.erase(edge_pair);
+        --number_of_edges_in_mdd;
+    }
+    if (const auto edge_index = find_edge(pred, succ); edge_index != NO_FLAT_NODE && --edge_counts[edge_index] == 0) {
+        released_edges.emplace_back(pred.flat_node_index, edge_index);
+    }
+}
+
+std::uint32_t mdd_flat_writeback::find_edge(const node &pred, const node &succ) const {
+    if (pred.flat_node_index == NO_FLAT_NODE || succ.flat_node_index == NO_FLAT_NODE) {
+        return NO_FLAT_NODE;
+    }
+    const auto first_succ = representative_edge_succs.begin() + first_representative_edges[pred.flat_node_index];
+    const auto end_succ = representative_edge_succs.begin() + first_representative_edges[pred.flat_node_index + 1];
+    const auto succ_position = std::lower_bound(first_succ, end_succ, succ.flat_node_index);
+    if (succ_position == end_succ || *succ_position != succ.flat_node_index) {
+        return NO_FLAT_NODE;
+    }
+    return representative_edges[succ_position - representative_edge_succs.begin()];
+}
+
+int mdd_flat_writeback::depth_of(const std::uint32_t node_index) const {
+    const auto *flat_levels = flat_mdd->levels();
+    const auto *level_end = flat_levels + flat_mdd->layout.level_capacity;
+    const auto *level = std::upper_bound(flat_levels, level_end, node_index,
+                                         [](const std::uint32_t index, const flat_level &flat_level) {
+                                             return index < flat_level.first_node;
+                                         });
+    return (level - 1)->depth;
+}
+
+int match_id_of(const node &node) {
+    return static_cast<const rflcs_graph::match *>(node.associated_match)->extension->match_id;
+}
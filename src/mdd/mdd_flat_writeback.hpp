@@ -0,0 +1,76 @@
+#pragma once
+
+#include "mdd.hpp"
+#include "shared_object.hpp"
+#include "absl/container/flat_hash_map.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct instance;
+
+/*
+ * Link between an mdd and the flat mdd in the shared object, which mirrors it by level and match.
+ * A flat node stays active while a node of its level has its match, a flat edge while such nodes are linked.
+ * Every node of the mdd knows the flat node of its match, and the hooks of the nodes and levels count
+ * the nodes and edges standing for each flat node and edge, so write_back only visits the flat entries
+ * whose count dropped to zero since the last write back. Nodes and edges are never added to the flat mdd.
+ * Every node and edge cleared by a reduction round is appended to the delta log of the shared object for the parent.
+ */
+struct mdd_flat_writeback {
+
+private:
+    shared_object *flat_mdd = nullptr;
+    // per flat node, the first flat node of its level with the same match, which stands for all of them
+    std::vector<std::uint32_t> representative_nodes = std::vector<std::uint32_t>();
+    std::vector<std::uint32_t> next_same_match_nodes = std::vector<std::uint32_t>(); // NO_FLAT_NODE at the end
+    // per flat edge, the next edge between flat nodes of the same two representatives
+    std::vector<std::uint32_t> next_same_match_edges = std::vector<std::uint32_t>();
+    // per representative, its edges by the representative of their successor, which are looked up by the hooks
+    std::vector<std::uint32_t> first_representative_edges = std::vector<std::uint32_t>(); // plus the end
+    std::vector<std::uint32_t> representative_edge_succs = std::vector<std::uint32_t>(); // ascending per node
+    std::vector<std::uint32_t> representative_edges = std::vector<std::uint32_t>(); // first flat edge of each pair
+    std::vector<std::uint32_t> node_counts = std::vector<std::uint32_t>(); // per representative node
+    std::vector<std::uint32_t> edge_counts = std::vector<std::uint32_t>(); // per first flat edge of a pair
+    std::vector<std::uint32_t> released_nodes = std::vector<std::uint32_t>();
+    // representative of the predecessor and first flat edge of the pair
+    std::vector<std::pair<std::uint32_t, std::uint32_t> > released_edges =
+            std::vector<std::pair<std::uint32_t, std::uint32_t> >();
+    std::vector<int> match_counts = std::vector<int>(); // per match id, nodes of the mdd in all levels
+    int number_of_matches_in_mdd = 0;
+    absl::flat_hash_map<long, int> edge_pair_counts = absl::flat_hash_map<long, int>(); // per pair of match ids
+    int number_of_edges_in_mdd = 0;
+
+    [[nodiscard]] std::uint32_t find_edge(const node &pred, const node &succ) const;
+
+    [[nodiscard]] int depth_of(std::uint32_t node_index) const;
+
+public:
+    // has to be called again whenever the flat mdd is serialized anew
+    void attach(const mdd &mdd, const instance &instance);
+
+    // stops the hooks of the levels of the mdd, e.g. before the writeback goes out of scope while the mdd lives on
+    static void detach(const mdd &mdd);
+
+    // clears the flat entries which lost their last counterpart in the mdd, a reduction round logs them for the parent
+    void write_back(bool is_logging);
+
+    // including the root match, as counted by the flat mdd
+    [[nodiscard]] int get_number_of_matches_in_mdd() const {
+        return number_of_matches_in_mdd;
+    }
+
+    // distinct pairs of matches linked in any level, as counted by the graph
+    [[nodiscard]] int get_number_of_edges_in_mdd() const {
+        return number_of_edges_in_mdd;
+    }
+
+    void node_joining(const node &node);
+
+    void node_leaving(const node &node);
+
+    void edge_linked(const node &pred, const node &succ);
+
+    void edge_unlinked(const node &pred, const node &succ);
+};
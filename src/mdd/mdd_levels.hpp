@@ -4,10 +4,48 @@
 
 typedef std::vector<node *> level_nodes_type;
 
+struct level_type;
+
+void record_level_for_undo(mdd_undo_log &undo_log, level_type &level);
+
+void write_back_node_joining(mdd_flat_writeback &flat_writeback, const node &node);
+
 struct level_type {
     level_nodes_type nodes = level_nodes_type();
     int depth = 0;
     bool needs_pruning;
+    bool is_recorded_for_undo = false;
+    dirty_nodes_type dirty_nodes = dirty_nodes_type();
+
+    void add_node(node *node) {
+        record_for_undo();
+        node->level_position = static_cast<unsigned int>(nodes.size());
+        nodes.push_back(node);
+        node->attach_to_level(dirty_nodes);
+        if (dirty_nodes.flat_writeback != nullptr) {
+            write_back_node_joining(*dirty_nodes.flat_writeback, *node);
+        }
+    }
+
+    template<typename Predicate>
+    void remove_nodes_if(Predicate &&is_removed) {
+        record_for_undo();
+        std::erase_if(nodes, std::forward<Predicate>(is_removed));
+        renumber_nodes();
+    }
+
+    void renumber_nodes() const {
+        for (unsigned int position = 0; position < nodes.size(); ++position) {
+            nodes[position]->level_position = position;
+        }
+    }
+
+    // saves the nodes of the level before their first change within a trial
+    void record_for_undo() {
+        if (!is_recorded_for_undo && dirty_nodes.undo_log != nullptr) {
+            record_level_for_undo(*dirty_nodes.undo_log, *this);
+        }
+    }
 
     ~level_type() {
         nodes.clear();
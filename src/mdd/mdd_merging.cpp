@@ -0,0 +1,184 @@
+#include "header/mdd_merging.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <ranges>
+#include <span>
+
+void merge_equivalent_nodes_of_level(level_type &level, mdd_node_source &mdd_node_source, scratch_space &scratch);
+
+void find_representatives(const level_type &level, scratch_space &scratch);
+
+bool have_same_sink_character_sets(const node &node_1, const node &node_2);
+
+void merge_into_representative(node *merged_node, node *representative, mdd_node_source &mdd_node_source);
+
+void merge_into_relaxation(node *merged_node, node *representative, mdd_node_source &mdd_node_source);
+
+void merge_equivalent_nodes(const mdd &mdd, mdd_node_source &mdd_node_source, solver_context &context) {
+    // bottom up, so the successors of a level are merged before the level is compared
+    for (const auto &level: mdd.levels | std::views::drop(1) | std::views::reverse) {
+        merge_equivalent_nodes_of_level(*level, mdd_node_source, context.scratch);
+    }
+}
+
+void merge_equivalent_nodes_of_level(level_type &level, mdd_node_source &mdd_node_source, scratch_space &scratch) {
+    if (level.nodes.size() <= 1) {
+        return;
+    }
+    find_representatives(level, scratch);
+
+    auto is_merged = false;
+    for (unsigned int position = 0; position < level.nodes.size(); ++position) {
+        if (const auto representative = scratch.representatives[position]; representative != position) {
+            merge_into_representative(level.nodes[position], level.nodes[representative], mdd_node_source);
+            is_merged = true;
+        }
+    }
+    if (is_merged) {
+        level.remove_nodes_if([](const auto *node) { return !node->is_active; });
+    }
+}
+
+// the representative of a node is the first equivalent node of the level
+void find_representatives(const level_type &level, scratch_space &scratch) {
+    const auto &nodes = level.nodes;
+    auto &succ_positions = scratch.succ_positions;
+    auto &first_succ_positions = scratch.first_succ_positions;
+    succ_positions.clear();
+    first_succ_positions.clear();
+    for (const auto node: nodes) {
+        first_succ_positions.push_back(succ_positions.size());
+        for (const auto succ: node->edges_out) {
+            succ_positions.push_back(succ->level_position);
+        }
+        std::sort(succ_positions.begin() + static_cast<long>(first_succ_positions.back()), succ_positions.end());
+    }
+    first_succ_positions.push_back(succ_positions.size());
+    const auto succs_of = [&succ_positions, &first_succ_positions](const unsigned int position) {
+        return std::span(succ_positions).subspan(first_succ_positions[position],
+                                                 first_succ_positions[position + 1] - first_succ_positions[position]);
+    };
+
+    // candidates share match and successors, stable so they stay in level order
+    auto &node_order = scratch.level_node_order;
+    node_order.resize(nodes.size());
+    std::iota(node_order.begin(), node_order.end(), 0);
+    std::ranges::stable_sort(node_order, [&nodes, &succs_of](const unsigned int position_1, const unsigned int position_2) {
+        if (nodes[position_1]->associated_match != nodes[position_2]->associated_match) {
+            return std::less()(nodes[position_1]->associated_match, nodes[position_2]->associated_match);
+        }
+        return std::ranges::lexicographical_compare(succs_of(position_1), succs_of(position_2));
+    });
+
+    auto &representatives = scratch.representatives;
+    representatives.resize(nodes.size());
+    auto group_begin = node_order.begin();
+    while (group_begin != node_order.end()) {
+        const auto group_end = std::find_if(group_begin + 1, node_order.end(), [&](const unsigned int position) {
+            return nodes[position]->associated_match != nodes[*group_begin]->associated_match
+                   || !std::ranges::equal(succs_of(position), succs_of(*group_begin));
+        });
+        for (auto candidate = group_begin; candidate != group_end; ++candidate) {
+            // representatives of the group represent themselves and precede the candidate
+            const auto representative = std::find_if(group_begin, candidate, [&](const unsigned int position) {
+                return representatives[position] == position
+                       && have_same_sink_character_sets(*nodes[position], *nodes[*candidate]);
+            });
+            representatives[*candidate] = representative == candidate ? *candidate : *representative;
+        }
+        group_begin = group_end;
+    }
+}
+
+// the sets towards the sinks, the sets towards the root are combined by the merge
+inline bool have_same_sink_character_sets(const node &node_1, const node &node_2) {
+    return node_1.characters_on_paths_to_some_sink == node_2.characters_on_paths_to_some_sink
+           && node_1.characters_on_all_paths_to_lower_bound_levels == node_2.characters_on_all_paths_to_lower_bound_levels;
+}
+
+void merge_into_representative(node *merged_node, node *representative, mdd_node_source &mdd_node_source) {
+    representative->record_for_undo();
+    for (const auto pred: merged_node->edges_in) {
+        if (std::ranges::find(pred->edges_out, representative) == pred->edges_out.end()) {
+            pred->link_pred_to_succ(representative);
+        }
+    }
+    representative->characters_on_paths_to_root |= merged_node->characters_on_paths_to_root;
+    representative->characters_on_all_paths_to_root &= merged_node->characters_on_all_paths_to_root;
+    representative->upper_bound_down = std::max(representative->upper_bound_down, merged_node->upper_bound_down);
+    mdd_node_source.clear_node(merged_node);
+}
+
+bool relax_level(level_type &level, const std::size_t max_width, mdd_node_source &mdd_node_source, scratch_space &scratch) {
+    if (level.nodes.size() <= max_width) {
+        return false;
+    }
+    const auto &nodes = level.nodes;
+
+    // nodes deactivated by a split are only removed with the merged ones, so they neither merge nor represent
+    auto &node_order = scratch.level_node_order;
+    node_order.clear();
+    for (unsigned int position = 0; position < nodes.size(); ++position) {
+        if (nodes[position]->is_active) {
+            node_order.push_back(position);
+        }
+    }
+    if (node_order.size() <= max_width) {
+        return false;
+    }
+
+    // the first node of a match represents the others, stable so it is the first in level order
+    std::ranges::stable_sort(node_order, std::less(),
+                             [&nodes](const unsigned int position) { return nodes[position]->associated_match; });
+    auto &representatives = scratch.representatives;
+    representatives.resize(nodes.size());
+    std::iota(representatives.begin(), representatives.end(), 0);
+    auto representative = node_order.front();
+    for (const auto position: node_order) {
+        if (nodes[position]->associated_match != nodes[representative]->associated_match) {
+            representative = position;
+        }
+        representatives[position] = representative;
+    }
+
+    auto is_merged = false;
+    auto number_of_excess_nodes = node_order.size() - max_width;
+    for (unsigned int position = 0; position < nodes.size() && number_of_excess_nodes > 0; ++position) {
+        if (representatives[position] != position) {
+            merge_into_relaxation(nodes[position], nodes[representatives[position]], mdd_node_source);
+            is_merged = true;
+            --number_of_excess_nodes;
+        }
+    }
+    if (is_merged) {
+        level.remove_nodes_if([](const auto *node) { return !node->is_active; });
+    }
+    return is_merged;
+}
+
+void merge_into_relaxation(node *merged_node, node *representative, mdd_node_source &mdd_node_source) {
+    representative->record_for_undo();
+    representative->characters_on_paths_to_root |= merged_node->characters_on_paths_to_root;
+    representative->characters_on_all_paths_to_root &= merged_node->characters_on_all_paths_to_root;
+    representative->characters_on_paths_to_some_sink |= merged_node->characters_on_paths_to_some_sink;
+    representative->characters_on_all_paths_to_lower_bound_levels &=
+            merged_node->characters_on_all_paths_to_lower_bound_levels;
+    representative->upper_bound_down = std::max(representative->upper_bound_down, merged_node->upper_bound_down);
+
+    for (const auto pred: merged_node->edges_in) {
+        if (std::ranges::find(pred->edges_out, representative) == pred->edges_out.end()) {
+            pred->link_pred_to_succ(representative);
+        }
+    }
+    for (const auto succ: merged_node->edges_out) {
+        if (std::ranges::find(representative->edges_out, succ) == representative->edges_out.end()) {
+            representative->link_pred_to_succ(succ);
+        }
+    }
+    mdd_node_source.clear_node(merged_node);
+
+    representative->notify_relatives_of_update();
+    representative->mark_for_update_from_pred();
+    representative->mark_for_update_from_succ();
+}
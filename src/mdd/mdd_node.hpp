@@ -1,14 +1,53 @@
 #pragma once
 
 #include "../graph/graph.hpp"
-#include "../temporaries.hpp"
+#include "../solver_context.hpp"
 #include "boost/dynamic_bitset.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <sstream>
 
 struct node;
 
+struct mdd_undo_log;
+
+struct mdd_flat_writeback;
+
+constexpr std::uint32_t NO_FLAT_NODE = std::numeric_limits<std::uint32_t>::max();
+
 typedef std::vector<node *> edges_type;
+typedef std::vector<unsigned int> edge_positions_type;
+
+/*
+ * Worklists of a level, fed whenever a needs_update_* flag of one of its nodes is raised,
+ * so filtering only visits the nodes whose relatives have changed.
+ * Entries of nodes which left the level or were already visited are skipped when the list is drained.
+ */
+struct dirty_nodes_type {
+    std::vector<node *> from_pred = std::vector<node *>();
+    std::vector<node *> from_succ = std::vector<node *>();
+    mdd_undo_log *undo_log = nullptr; // of the trial running on the mdd of the level
+    mdd_flat_writeback *flat_writeback = nullptr; // of the mdd of the level, if the flat mdd mirrors it
+};
+
+void record_node_for_undo(mdd_undo_log &undo_log, node &node);
+
+void write_back_node_leaving(mdd_flat_writeback &flat_writeback, const node &node);
+
+void write_back_linked_edge(mdd_flat_writeback &flat_writeback, const node &pred, const node &succ);
+
+void write_back_unlinked_edge(mdd_flat_writeback &flat_writeback, const node &pred, const node &succ);
+
+// relatives of a node which have to be marked for an update after the node has changed
+struct relatives_to_notify {
+    bool preds = false;
+    bool succs = false;
+
+    [[nodiscard]] bool any() const {
+        return preds || succs;
+    }
+};
 
 struct node {
     Character_set characters_on_paths_to_root; // including match character
@@ -17,6 +56,11 @@ struct node {
     Character_set characters_on_all_paths_to_lower_bound_levels; // not including match character
     edges_type edges_out = edges_type();
     edges_type edges_in = edges_type();
+    edge_positions_type edges_out_positions = edge_positions_type(); // position of this node in edges_in of the succ
+    edge_positions_type edges_in_positions = edge_positions_type(); // position of this node in edges_out of the pred
+    dirty_nodes_type *dirty_nodes = nullptr; // of the level holding this node
+    unsigned int level_position = 0; // in the nodes of the level holding this node, identifies the node within its mdd
+    std::uint32_t flat_node_index = NO_FLAT_NODE; // of the flat node standing for the match of this node in its level
     void *associated_match = nullptr;
     Character character;
     int position_1;
@@ -24,17 +68,45 @@ struct node {
     int upper_bound_down = std::numeric_limits<int>::max() / 4; // not including match character
     bool needs_update_from_pred = true;
     bool needs_update_from_succ = true;
+    bool is_queued_from_pred = false;
+    bool is_queued_from_succ = false;
     bool is_active = true;
+    bool is_recorded_for_undo = false; // by the undo log of the running trial, or created by the trial
+
+    node() = default; // character sets on the heap, for nodes outside of a node source
+
+    explicit node(Character_set_block *bitset_storage); // room for blocks_per_node() blocks
+
+    static std::size_t blocks_per_node();
 
     void clear();
 
+    void record_for_undo();
+
     void link_pred_to_succ(node *succ);
 
     void unlink_pred_from_succ(node *succ);
 
-    bool update_from_preds(int depth);
+    void unlink_out_edge(std::size_t out_index);
+
+    void unlink_in_edge(std::size_t in_index);
+
+    void clear_edges();
+
+    void attach_to_level(dirty_nodes_type &level_dirty_nodes);
 
-    bool update_from_succs(int depth, int lower_bound);
+    void detach_from_level();
+
+    void mark_for_update_from_pred();
+
+    void mark_for_update_from_succ();
+
+    // only write this node, the relatives are marked by notify_of_update
+    relatives_to_notify update_from_preds(int depth, scratch_space &scratch);
+
+    relatives_to_notify update_from_succs(int depth, int lower_bound, scratch_space &scratch);
+
+    void notify_of_update(relatives_to_notify relatives) const;
 
     void notify_relatives_of_update() const;
 
@@ -47,53 +119,174 @@ struct node {
     [[maybe_unused]] [[nodiscard]] std::string to_string() const;
 };
 
+inline node::node(Character_set_block *bitset_storage)
+    : characters_on_paths_to_root(bitset_storage),
+      characters_on_all_paths_to_root(bitset_storage + blocks_per_character_set()),
+      characters_on_paths_to_some_sink(bitset_storage + 2 * blocks_per_character_set()),
+      characters_on_all_paths_to_lower_bound_levels(bitset_storage + 3 * blocks_per_character_set()) {
+}
+
+inline std::size_t node::blocks_per_node() {
+    return 4 * blocks_per_character_set();
+}
+
 inline void node::clear() {
+    this->record_for_undo();
+    if (this->dirty_nodes != nullptr && this->dirty_nodes->flat_writeback != nullptr) {
+        write_back_node_leaving(*this->dirty_nodes->flat_writeback, *this);
+    }
     this->is_active = false;
-    this->associated_match = nullptr;
-    for (auto *pred: edges_in) {
-        std::erase(pred->edges_out, this);
-        pred->needs_update_from_succ = true;
+    // the writeback counts the unlinked edges by the matches of both ends
+    while (!edges_in.empty()) {
+        this->unlink_in_edge(edges_in.size() - 1);
     }
-    this->edges_in.clear();
-    for (auto *succ: edges_out) {
-        std::erase(succ->edges_in, this);
-        succ->needs_update_from_pred = true;
+    while (!edges_out.empty()) {
+        this->unlink_out_edge(edges_out.size() - 1);
     }
-    this->edges_out.clear();
+    this->associated_match = nullptr;
     this->characters_on_paths_to_root.set();
     this->characters_on_all_paths_to_root.reset();
     this->characters_on_paths_to_some_sink.set();
     this->characters_on_all_paths_to_lower_bound_levels.reset();
     this->needs_update_from_pred = false;
     this->needs_update_from_succ = false;
+    this->detach_from_level();
+}
+
+// saves the state of the node before its first change within a trial
+inline void node::record_for_undo() {
+    if (!this->is_recorded_for_undo && this->dirty_nodes != nullptr && this->dirty_nodes->undo_log != nullptr) {
+        record_node_for_undo(*this->dirty_nodes->undo_log, *this);
+    }
+}
+
+/*
+ * Edges are stored on both ends with the position of the opposite entry,
+ * so an edge with a known position is removed in O(1) by swapping in the last edge of each list.
+ */
+// a node may be linked before it joins its level, so either end leads to the writeback
+inline mdd_flat_writeback *flat_writeback_of_edge(const node &pred, const node &succ) {
+    if (pred.dirty_nodes != nullptr && pred.dirty_nodes->flat_writeback != nullptr) {
+        return pred.dirty_nodes->flat_writeback;
+    }
+    return succ.dirty_nodes != nullptr ? succ.dirty_nodes->flat_writeback : nullptr;
 }
 
 inline void node::link_pred_to_succ(node *succ) {
+    this->record_for_undo();
+    succ->record_for_undo();
+    if (const auto flat_writeback = flat_writeback_of_edge(*this, *succ); flat_writeback != nullptr) {
+        write_back_linked_edge(*flat_writeback, *this, *succ);
+    }
+    this->edges_out_positions.push_back(static_cast<unsigned int>(succ->edges_in.size()));
+    succ->edges_in_positions.push_back(static_cast<unsigned int>(this->edges_out.size()));
     this->edges_out.push_back(succ);
     succ->edges_in.push_back(this);
 }
 
 inline void node::unlink_pred_from_succ(node *succ) {
-    std::erase(this->edges_out, succ);
-    std::erase(succ->edges_in, this);
+    if (this->edges_out.size() <= succ->edges_in.size()) {
+        this->unlink_out_edge(std::ranges::find(this->edges_out, succ) - this->edges_out.begin());
+    } else {
+        succ->unlink_in_edge(std::ranges::find(succ->edges_in, this) - succ->edges_in.begin());
+    }
+}
+
+inline void node::unlink_out_edge(const std::size_t out_index) {
+    node *succ = this->edges_out[out_index];
+    const std::size_t in_index = this->edges_out_positions[out_index];
+    this->record_for_undo();
+    succ->record_for_undo();
+    if (const auto flat_writeback = flat_writeback_of_edge(*this, *succ); flat_writeback != nullptr) {
+        write_back_unlinked_edge(*flat_writeback, *this, *succ);
+    }
+
+    if (out_index + 1 < this->edges_out.size()) {
+        this->edges_out.back()->record_for_undo();
+        this->edges_out[out_index] = this->edges_out.back();
+        this->edges_out_positions[out_index] = this->edges_out_positions.back();
+        this->edges_out[out_index]->edges_in_positions[this->edges_out_positions[out_index]] = out_index;
+    }
+    this->edges_out.pop_back();
+    this->edges_out_positions.pop_back();
+
+    if (in_index + 1 < succ->edges_in.size()) {
+        succ->edges_in.back()->record_for_undo();
+        succ->edges_in[in_index] = succ->edges_in.back();
+        succ->edges_in_positions[in_index] = succ->edges_in_positions.back();
+        succ->edges_in[in_index]->edges_out_positions[succ->edges_in_positions[in_index]] = in_index;
+    }
+    succ->edges_in.pop_back();
+    succ->edges_in_positions.pop_back();
+
+    this->mark_for_update_from_succ();
+    succ->mark_for_update_from_pred();
+}
+
+inline void node::unlink_in_edge(const std::size_t in_index) {
+    this->edges_in[in_index]->unlink_out_edge(this->edges_in_positions[in_index]);
+}
+
+// drops all edges without updating the relatives, which have to be released as well
+inline void node::clear_edges() {
+    this->edges_out.clear();
+    this->edges_in.clear();
+    this->edges_out_positions.clear();
+    this->edges_in_positions.clear();
+}
+
+// queues the pending updates of a node which joins a level
+inline void node::attach_to_level(dirty_nodes_type &level_dirty_nodes) {
+    this->dirty_nodes = &level_dirty_nodes;
+    this->is_queued_from_pred = false;
+    this->is_queued_from_succ = false;
+    if (this->needs_update_from_pred) {
+        this->mark_for_update_from_pred();
+    }
+    if (this->needs_update_from_succ) {
+        this->mark_for_update_from_succ();
+    }
+}
+
+inline void node::detach_from_level() {
+    this->dirty_nodes = nullptr;
+    this->is_queued_from_pred = false;
+    this->is_queued_from_succ = false;
+}
+
+inline void node::mark_for_update_from_pred() {
+    this->record_for_undo();
+    this->needs_update_from_pred = true;
+    if (this->dirty_nodes != nullptr && !this->is_queued_from_pred) {
+        this->is_queued_from_pred = true;
+        this->dirty_nodes->from_pred.push_back(this);
+    }
+}
+
+inline void node::mark_for_update_from_succ() {
+    this->record_for_undo();
     this->needs_update_from_succ = true;
-    succ->needs_update_from_pred = true;
+    if (this->dirty_nodes != nullptr && !this->is_queued_from_succ) {
+        this->is_queued_from_succ = true;
+        this->dirty_nodes->from_succ.push_back(this);
+    }
 }
 
-inline bool node::update_from_preds(const int depth) {
+inline relatives_to_notify node::update_from_preds(const int depth, scratch_space &scratch) {
+    this->record_for_undo();
     this->needs_update_from_pred = false;
 
-    temporaries::old_characters_on_paths_to_root = this->characters_on_paths_to_root;
-    temporaries::old_characters_on_all_paths_to_root = this->characters_on_all_paths_to_root;
-    temporaries::old_characters_on_paths_to_some_sink = this->characters_on_paths_to_some_sink;
+    scratch.old_characters_on_paths_to_root = this->characters_on_paths_to_root;
+    scratch.old_characters_on_all_paths_to_root = this->characters_on_all_paths_to_root;
+    scratch.old_characters_on_paths_to_some_sink = this->characters_on_paths_to_some_sink;
 
-    temporaries::temp_character_set_1.reset();
+    scratch.temp_character_set_1.reset();
     this->characters_on_all_paths_to_root.set();
     for (const auto pred: this->edges_in) {
-        temporaries::temp_character_set_1 |= pred->characters_on_paths_to_root;
+        scratch.temp_character_set_1 |= pred->characters_on_paths_to_root;
         this->characters_on_all_paths_to_root &= pred->characters_on_all_paths_to_root;
     }
-    this->characters_on_paths_to_root &= temporaries::temp_character_set_1;
+    this->characters_on_paths_to_root &= scratch.temp_character_set_1;
     this->characters_on_paths_to_root.set(this->character);
     this->characters_on_all_paths_to_root.set(this->character);
     if (depth == static_cast<int>(this->characters_on_paths_to_root.count())) {
@@ -101,37 +294,28 @@ inline bool node::update_from_preds(const int depth) {
     }
     this->characters_on_paths_to_some_sink &= ~ this->characters_on_all_paths_to_root;
 
-    temporaries::old_characters_on_paths_to_root &= ~ this->characters_on_paths_to_root;
-    temporaries::old_characters_on_all_paths_to_root ^= this->characters_on_all_paths_to_root;
-    temporaries::old_characters_on_paths_to_some_sink &= ~ this->characters_on_paths_to_some_sink;
-    const bool notify_preds = temporaries::old_characters_on_paths_to_some_sink.any();
-    const bool notify_succs = temporaries::old_characters_on_paths_to_root.any()
-                              || temporaries::old_characters_on_all_paths_to_root.any();
-    if (notify_preds && notify_succs) {
-      this->notify_relatives_of_update();
-    } else {
-        if (notify_preds) {
-            this->notify_preds_of_update();
-        }
-        if (notify_succs) {
-            this->notify_succs_of_update();
-        }
-    }
-
-    return notify_succs || notify_preds;
+    scratch.old_characters_on_paths_to_root &= ~ this->characters_on_paths_to_root;
+    scratch.old_characters_on_all_paths_to_root ^= this->characters_on_all_paths_to_root;
+    scratch.old_characters_on_paths_to_some_sink &= ~ this->characters_on_paths_to_some_sink;
+    return relatives_to_notify{
+        .preds = scratch.old_characters_on_paths_to_some_sink.any(),
+        .succs = scratch.old_characters_on_paths_to_root.any() || scratch.old_characters_on_all_paths_to_root.any()
+    };
 }
 
-inline bool node::update_from_succs(const int depth, const int lower_bound) {
+inline relatives_to_notify node::update_from_succs(const int depth, const int lower_bound, scratch_space &scratch) {
+    this->record_for_undo();
     this->needs_update_from_succ = false;
-    temporaries::old_characters_on_paths_to_some_sink = this->characters_on_paths_to_some_sink;
-    temporaries::old_characters_on_all_paths_to_lower_bound_levels = this->characters_on_all_paths_to_lower_bound_levels;
+    auto relatives = relatives_to_notify();
+    scratch.old_characters_on_paths_to_some_sink = this->characters_on_paths_to_some_sink;
+    scratch.old_characters_on_all_paths_to_lower_bound_levels = this->characters_on_all_paths_to_lower_bound_levels;
     const int old_upper_bound_down = this->upper_bound_down;
 
     if (this->edges_out.empty()) {
         if (this->characters_on_paths_to_some_sink.any()
             || this->characters_on_all_paths_to_lower_bound_levels.any()
             || this->upper_bound_down > 0) {
-            this->notify_preds_of_update();
+            relatives.preds = true;
         }
         this->upper_bound_down = 0;
         this->characters_on_paths_to_some_sink.reset();
@@ -139,19 +323,19 @@ inline bool node::update_from_succs(const int depth, const int lower_bound) {
     }
 
     auto max_upper_bound_down_succ = 0;
-    temporaries::temp_character_set_1.reset();
+    scratch.temp_character_set_1.reset();
     this->characters_on_all_paths_to_lower_bound_levels.set();
     for (const auto succ: this->edges_out) {
         max_upper_bound_down_succ = std::max(max_upper_bound_down_succ, succ->upper_bound_down);
-        temporaries::temp_character_set_1 |= succ->characters_on_paths_to_some_sink;
-        temporaries::temp_character_set_1.set(succ->character);
-        temporaries::temp_character_set_2 = succ->characters_on_all_paths_to_lower_bound_levels;
+        scratch.temp_character_set_1 |= succ->characters_on_paths_to_some_sink;
+        scratch.temp_character_set_1.set(succ->character);
+        scratch.temp_character_set_2 = succ->characters_on_all_paths_to_lower_bound_levels;
         if (depth > 0 && depth <= lower_bound) {
-            temporaries::temp_character_set_2.set(succ->character);
+            scratch.temp_character_set_2.set(succ->character);
         }
-        this->characters_on_all_paths_to_lower_bound_levels &= temporaries::temp_character_set_2;
+        this->characters_on_all_paths_to_lower_bound_levels &= scratch.temp_character_set_2;
     }
-    this->characters_on_paths_to_some_sink &= temporaries::temp_character_set_1;
+    this->characters_on_paths_to_some_sink &= scratch.temp_character_set_1;
 
     if (this->edges_out.empty()) {
         this->characters_on_all_paths_to_lower_bound_levels.reset();
@@ -161,39 +345,43 @@ inline bool node::update_from_succs(const int depth, const int lower_bound) {
     this->upper_bound_down = std::min(this->upper_bound_down,
                                       static_cast<int>(this->characters_on_paths_to_some_sink.count()));
 
-    const bool notify_relatives = old_upper_bound_down > this->upper_bound_down;
-    temporaries::old_characters_on_paths_to_some_sink &= ~ this->characters_on_paths_to_some_sink;
-    temporaries::old_characters_on_all_paths_to_lower_bound_levels ^= this->characters_on_all_paths_to_lower_bound_levels;
-    const bool notify_preds = temporaries::old_characters_on_paths_to_some_sink.any() ||
-                              temporaries::old_characters_on_all_paths_to_lower_bound_levels.any();
+    scratch.old_characters_on_paths_to_some_sink &= ~ this->characters_on_paths_to_some_sink;
+    scratch.old_characters_on_all_paths_to_lower_bound_levels ^= this->characters_on_all_paths_to_lower_bound_levels;
+    relatives.succs = old_upper_bound_down > this->upper_bound_down;
+    relatives.preds |= relatives.succs
+            || scratch.old_characters_on_paths_to_some_sink.any()
+            || scratch.old_characters_on_all_paths_to_lower_bound_levels.any();
+    return relatives;
+}
 
-    if (notify_relatives) {
+inline void node::notify_of_update(const relatives_to_notify relatives) const {
+    if (relatives.preds && relatives.succs) {
         this->notify_relatives_of_update();
-    } else if (notify_preds) {
+    } else if (relatives.preds) {
         this->notify_preds_of_update();
+    } else if (relatives.succs) {
+        this->notify_succs_of_update();
     }
-
-    return notify_relatives || notify_preds;
 }
 
 inline void node::notify_relatives_of_update() const {
     for (auto *pred: this->edges_in) {
-        pred->needs_update_from_succ = true;
+        pred->mark_for_update_from_succ();
     }
     for (auto *succ: this->edges_out) {
-        succ->needs_update_from_pred = true;
+        succ->mark_for_update_from_pred();
     }
 }
 
 inline void node::notify_succs_of_update() const {
     for (auto *succ: this->edges_out) {
-        succ->needs_update_from_pred = true;
+        succ->mark_for_update_from_pred();
     }
 }
 
 inline void node::notify_preds_of_update() const {
     for (auto *pred: this->edges_in) {
-        pred->needs_update_from_succ = true;
+        pred->mark_for_update_from_succ();
     }
 }
 
@@ -208,11 +396,12 @@ inline void node::notify_preds_of_update() const {
 }
 
 inline void node::deactivate() {
-    for (const auto pred: edges_in) {
-        pred->unlink_pred_from_succ(this);
+    this->record_for_undo();
+    while (!edges_in.empty()) {
+        this->unlink_in_edge(edges_in.size() - 1);
     }
-    for (const auto succ: edges_out) {
-        this->unlink_pred_from_succ(succ);
+    while (!edges_out.empty()) {
+        this->unlink_out_edge(edges_out.size() - 1);
     }
     this->is_active = false;
 }
@@ -3,15 +3,62 @@
 #include "mdd_node.hpp"
 
 #include <algorithm>
+#include <memory>
 
+void record_created_node_for_undo(mdd_undo_log &undo_log, node &node);
+
+/*
+ * Nodes are bump allocated from slabs, which also hold the blocks of the four character sets of every node.
+ * Cleared nodes are recycled through the cache, and release_all hands back every node of the source at once.
+ */
 struct mdd_node_source {
 
 private:
+    static constexpr std::size_t nodes_per_slab = 1 << 12;
+
+    struct node_slab {
+        std::vector<Character_set_block> blocks = std::vector<Character_set_block>();
+        std::vector<node> nodes = std::vector<node>();
+        std::size_t used = 0;
+    };
+
     std::vector<node *> cache= std::vector<node *>();
+    std::vector<std::unique_ptr<node_slab> > slabs = std::vector<std::unique_ptr<node_slab> >();
+    std::size_t active_slab = 0;
+
+    [[nodiscard]] node *bump_node() {
+        while (active_slab < slabs.size() && slabs[active_slab]->used == nodes_per_slab) {
+            active_slab++;
+        }
+        if (active_slab == slabs.size()) {
+            auto &slab = *slabs.emplace_back(std::make_unique<node_slab>());
+            slab.blocks.resize(nodes_per_slab * node::blocks_per_node());
+            slab.nodes.reserve(nodes_per_slab);
+        }
+        auto &slab = *slabs[active_slab];
+        if (slab.used < slab.nodes.size()) {
+            // handed out before the last release_all, its relatives are released as well
+            auto *reused_node = &slab.nodes[slab.used++];
+            reused_node->clear_edges();
+            reused_node->detach_from_level();
+            return reused_node;
+        }
+        slab.used++;
+        return &slab.nodes.emplace_back(slab.blocks.data() + slab.nodes.size() * node::blocks_per_node());
+    }
 
 public:
+    mdd_undo_log *undo_log = nullptr; // of a running trial, which hands back the nodes it created on rollback
+
     void clear_node(node *node) {
         node->clear();
+        if (undo_log == nullptr) {
+            cache.push_back(node);
+        }
+    }
+
+    // for nodes without relatives, e.g. the nodes created by a trial which has been rolled back
+    void recycle_node(node *node) {
         cache.push_back(node);
     }
 
@@ -19,34 +66,53 @@ public:
         std::ranges::sort(cache);
     }
 
-    [[nodiscard]] node* new_node() {
-        if(!cache.empty()) {
-            const auto node = cache.back();
-            cache.pop_back();
-            return node;
+    // All nodes of this source must be unreferenced, e.g. after a trial copy of an mdd has been evaluated.
+    void release_all() {
+        cache.clear();
+        for (const auto &slab: slabs) {
+            slab->used = 0;
         }
-        return new node();
+        active_slab = 0;
     }
 
-    [[nodiscard]] node *get_new_node_with_match(rflcs_graph::match &match) {
+    // bytes of the slabs and of the edges of their nodes, which a cleared node keeps for its reuse
+    [[nodiscard]] std::size_t get_memory_consumption() const {
+        auto bytes = cache.capacity() * sizeof(node *);
+        for (const auto &slab: slabs) {
+            bytes += slab->blocks.capacity() * sizeof(Character_set_block) + slab->nodes.capacity() * sizeof(node);
+            for (const auto &slab_node: slab->nodes) {
+                bytes += (slab_node.edges_out.capacity() + slab_node.edges_in.capacity()) * sizeof(node *)
+                        + (slab_node.edges_out_positions.capacity() + slab_node.edges_in_positions.capacity())
+                        * sizeof(unsigned int);
+            }
+        }
+        return bytes;
+    }
 
+    [[nodiscard]] node* new_node() {
         node *fresh_node;
-        if (cache.empty()) {
-            fresh_node = new_node();
-            fresh_node->characters_on_paths_to_root = match.reversed->extension->available_characters;
-            fresh_node->characters_on_all_paths_to_root = Character_set();
-            fresh_node->characters_on_paths_to_some_sink = match.extension->available_characters;
-            fresh_node->characters_on_all_paths_to_lower_bound_levels = Character_set();
-        } else {
+        if(!cache.empty()) {
             fresh_node = cache.back();
             cache.pop_back();
-            fresh_node->characters_on_paths_to_root = match.reversed->extension->available_characters;
-            fresh_node->characters_on_all_paths_to_root.reset();
-            fresh_node->characters_on_paths_to_some_sink = match.extension->available_characters;
-            fresh_node->characters_on_all_paths_to_lower_bound_levels.reset();
+        } else {
+            fresh_node = bump_node();
+        }
+        if (undo_log != nullptr) {
+            record_created_node_for_undo(*undo_log, *fresh_node);
         }
+        return fresh_node;
+    }
+
+    [[nodiscard]] node *get_new_node_with_match(rflcs_graph::match &match) {
+
+        node *fresh_node = new_node();
+        fresh_node->characters_on_paths_to_root = match.reversed->extension->available_characters;
+        fresh_node->characters_on_all_paths_to_root.reset();
+        fresh_node->characters_on_paths_to_some_sink = match.extension->available_characters;
+        fresh_node->characters_on_all_paths_to_lower_bound_levels.reset();
         fresh_node->is_active = true;
         fresh_node->associated_match = &match;
+        fresh_node->flat_node_index = NO_FLAT_NODE;
         fresh_node->character = match.character;
         fresh_node->position_1 = match.extension->position_1;
         fresh_node->position_2 = match.extension->position_2;
@@ -62,23 +128,14 @@ public:
     }
 
     [[nodiscard]] node *get_copy_of_old_node(const node &old_node) {
-        node *fresh_node;
-        if (cache.empty()) {
-            fresh_node = new_node();
-            fresh_node->characters_on_paths_to_root = old_node.characters_on_paths_to_root;
-            fresh_node->characters_on_all_paths_to_root = old_node.characters_on_all_paths_to_root;
-            fresh_node->characters_on_paths_to_some_sink = old_node.characters_on_paths_to_some_sink;
-            fresh_node->characters_on_all_paths_to_lower_bound_levels = old_node.characters_on_all_paths_to_lower_bound_levels;
-        } else {
-            fresh_node = cache.back();
-            cache.pop_back();
-            fresh_node->characters_on_paths_to_root = old_node.characters_on_paths_to_root;
-            fresh_node->characters_on_all_paths_to_root = old_node.characters_on_all_paths_to_root;
-            fresh_node->characters_on_paths_to_some_sink = old_node.characters_on_paths_to_some_sink;
-            fresh_node->characters_on_all_paths_to_lower_bound_levels = old_node.characters_on_all_paths_to_lower_bound_levels;
-        }
+        node *fresh_node = new_node();
+        fresh_node->characters_on_paths_to_root = old_node.characters_on_paths_to_root;
+        fresh_node->characters_on_all_paths_to_root = old_node.characters_on_all_paths_to_root;
+        fresh_node->characters_on_paths_to_some_sink = old_node.characters_on_paths_to_some_sink;
+        fresh_node->characters_on_all_paths_to_lower_bound_levels = old_node.characters_on_all_paths_to_lower_bound_levels;
         fresh_node->is_active = true;
         fresh_node->associated_match = old_node.associated_match;
+        fresh_node->flat_node_index = old_node.flat_node_index;
         fresh_node->character = old_node.character;
         fresh_node->position_1 = old_node.position_1;
         fresh_node->position_2 = old_node.position_2;
@@ -90,23 +147,14 @@ public:
     }
 
     [[nodiscard]] node *get_copy_of_old_node_with_copy_helper(const node *old_node) {
-        node *fresh_node;
-        if (cache.empty()) {
-            fresh_node = new_node();
-            fresh_node->characters_on_paths_to_root = old_node->characters_on_paths_to_root;
-            fresh_node->characters_on_all_paths_to_root = old_node->characters_on_all_paths_to_root;
-            fresh_node->characters_on_paths_to_some_sink = old_node->characters_on_paths_to_some_sink;
-            fresh_node->characters_on_all_paths_to_lower_bound_levels = old_node->characters_on_all_paths_to_lower_bound_levels;
-        } else {
-            fresh_node = cache.back();
-            cache.pop_back();
-            fresh_node->characters_on_paths_to_root = old_node->characters_on_paths_to_root;
-            fresh_node->characters_on_all_paths_to_root = old_node->characters_on_all_paths_to_root;
-            fresh_node->characters_on_paths_to_some_sink = old_node->characters_on_paths_to_some_sink;
-            fresh_node->characters_on_all_paths_to_lower_bound_levels = old_node->characters_on_all_paths_to_lower_bound_levels;
-        }
+        node *fresh_node = new_node();
+        fresh_node->characters_on_paths_to_root = old_node->characters_on_paths_to_root;
+        fresh_node->characters_on_all_paths_to_root = old_node->characters_on_all_paths_to_root;
+        fresh_node->characters_on_paths_to_some_sink = old_node->characters_on_paths_to_some_sink;
+        fresh_node->characters_on_all_paths_to_lower_bound_levels = old_node->characters_on_all_paths_to_lower_bound_levels;
         fresh_node->is_active = true;
         fresh_node->associated_match = old_node->associated_match;
+        fresh_node->flat_node_index = old_node->flat_node_index;
         fresh_node->character = old_node->character;
         fresh_node->position_1 = old_node->position_1;
         fresh_node->position_2 = old_node->position_2;
@@ -117,8 +165,4 @@ public:
 
         return fresh_node;
     }
-
-    ~mdd_node_source() {
-        cache.clear();
-    }
 };
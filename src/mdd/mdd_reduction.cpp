@@ -4,9 +4,16 @@
 #include "../constants.hpp"
 #include "header/character_selection.hpp"
 #include "header/mdd_filter.hpp"
+#include "header/mdd_merging.hpp"
 #include "header/initial_mdd.hpp"
+#include "mdd_flat_writeback.hpp"
+#include "../checkpoint.hpp"
+#include "../config.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <memory>
+#include <span>
 #include <vector>
 #include <iostream>
 #include <fstream>
@@ -16,6 +23,11 @@ void make_only_one_best_solution_remaining(
     mdd_node_source &mdd_node_source,
     const mdd &mdd_reduction);
 
+bool is_reduction_stopped(const instance &instance,
+                          const mdd_node_source &mdd_node_source,
+                          const character_selection_workspace &trial_workspace,
+                          const std::stop_token &stop_token);
+
 inline bool is_power_of_2(const int n) {
     return n > 0 && (n & n - 1) == 0;
 }
@@ -40,15 +52,21 @@ void add_counts(const mdd &mdd_reduction, std::vector<long> &time_series_node_co
     time_series_edge_count.push_back(edge_count);
 }
 
-void reduce_by_mdd(const instance &instance) {
+void reduce_by_mdd(const instance &instance, const std::stop_token &stop_token) {
     const auto mdd_node_source = std::make_unique<struct mdd_node_source>();
+    auto trial_workspace = character_selection_workspace();
+    auto context = instance.context;
+    context.stop_token = stop_token;
 
     auto refining_mdd = mdd::copy_mdd(*instance.mdd, *mdd_node_source);
-    prune_by_flat_mdd(instance.shared_object, *refining_mdd, *mdd_node_source);
-    filter_mdd(instance, *refining_mdd, *mdd_node_source);
+    prune_by_flat_mdd(instance.shared_object, *refining_mdd, *mdd_node_source, context.scratch);
+    auto flat_writeback = mdd_flat_writeback();
+    flat_writeback.attach(*refining_mdd, instance);
+    filter_mdd(instance, *refining_mdd, *mdd_node_source, context);
+    merge_equivalent_nodes(*refining_mdd, *mdd_node_source, context);
     auto compact_mdd = mdd::copy_mdd(*refining_mdd, *mdd_node_source);
 
-    if (temporaries::lower_bound >= temporaries::upper_bound) {
+    if (context.lower_bound >= context.upper_bound) {
         instance.shared_object->is_mdd_reduction_complete = true;
         return;
     }
@@ -64,8 +82,13 @@ void reduce_by_mdd(const instance &instance) {
         update_characters_ordered_by_importance_mdd(characters_ordered_by_importance,
                                                     instance,
                                                     *refining_mdd,
-                                                    *mdd_node_source,
+                                                    trial_workspace,
+                                                    context,
                                                     &progress);
+        if (is_reduction_stopped(instance, *mdd_node_source, trial_workspace, stop_token)) {
+            filter_flat_mdd(instance, *refining_mdd, flat_writeback, true);
+            return;
+        }
     } else if (instance.shared_object->refinement_round % 3 == 1) {
         std::cout << "Applying Shuffle strategy." << std::endl;
         static std::random_device rd;
@@ -76,7 +99,7 @@ void reduce_by_mdd(const instance &instance) {
         std::ranges::sort(
             characters_ordered_by_importance,
             std::greater{},
-            [](const Character c) { return temporaries::chaining_numbers[c]; }
+            [&context](const Character c) { return context.chaining_numbers[c]; }
         );
     }
 
@@ -86,34 +109,51 @@ void reduce_by_mdd(const instance &instance) {
     std::cout << "..." << std::endl;
 
     instance.shared_object->number_of_refined_characters = 0;
-    for (int refinement_character_index: std::views::iota(0, constants::alphabet_size)) {
+    auto refinement_character_index = 0;
+    while (refinement_character_index < constants::alphabet_size) {
         if (is_power_of_2(refinement_character_index)) {
 #ifndef MDD_FREQUENT_SAVE_FEATURE
-            filter_flat_mdd(instance, *refining_mdd, true);
+            filter_flat_mdd(instance, *refining_mdd, flat_writeback, true);
 #endif
+            write_checkpoint(instance);
             auto range = characters_ordered_by_importance
                          | std::views::drop(refinement_character_index)
                          | std::views::take(2 * refinement_character_index);
             auto sub_characters = std::vector(range.begin(), range.end());
 
-            prune_by_flat_mdd(instance.shared_object, *compact_mdd, *mdd_node_source);
-            serialize_initial_mdd(*compact_mdd, instance.shared_object);
+            prune_by_flat_mdd(instance.shared_object, *compact_mdd, *mdd_node_source, context.scratch);
+            serialize_initial_mdd(*compact_mdd, instance.shared_object, context.scratch);
+            flat_writeback.attach(*refining_mdd, instance);
             update_characters_ordered_by_importance_mdd(sub_characters,
                                                         instance,
                                                         *compact_mdd,
-                                                        *mdd_node_source,
+                                                        trial_workspace,
+                                                        context,
                                                         nullptr);
+            if (is_reduction_stopped(instance, *mdd_node_source, trial_workspace, stop_token)) {
+                filter_flat_mdd(instance, *refining_mdd, flat_writeback, true);
+                return;
+            }
             std::ranges::copy(sub_characters, characters_ordered_by_importance.begin() + refinement_character_index);
         }
 
-        auto split_character = characters_ordered_by_importance[refinement_character_index];
-        refine_mdd(*refining_mdd, split_character, *mdd_node_source);
-        filter_mdd(instance, *refining_mdd, *mdd_node_source);
-        instance.shared_object->number_of_refined_characters++;
+        // a batch never spans a re-selection, which happens at the next power of 2
+        const auto batch_end = std::min({
+            refinement_character_index + REFINEMENT_BATCH_SIZE,
+            static_cast<int>(std::bit_ceil(static_cast<unsigned int>(refinement_character_index) + 1)),
+            constants::alphabet_size
+        });
+        const auto split_characters = std::span(characters_ordered_by_importance)
+                .subspan(refinement_character_index, batch_end - refinement_character_index);
+        refine_mdd(*refining_mdd, split_characters, *mdd_node_source, context);
+        filter_mdd(instance, *refining_mdd, *mdd_node_source, context);
+        merge_equivalent_nodes(*refining_mdd, *mdd_node_source, context);
+        instance.shared_object->number_of_refined_characters += static_cast<int>(split_characters.size());
+        refinement_character_index = batch_end;
         instance.shared_object->upper_bound =
                 std::min(instance.shared_object->upper_bound, refining_mdd->levels.back()->depth);
         instance.shared_object->upper_bound =
-                std::max(instance.shared_object->upper_bound, temporaries::lower_bound);
+                std::max(instance.shared_object->upper_bound, context.lower_bound);
         if (!refining_mdd->levels.empty()) {
             instance.shared_object->upper_bound =
                     std::max(instance.shared_object->upper_bound,
@@ -121,17 +161,27 @@ void reduce_by_mdd(const instance &instance) {
         }
 
 #ifdef MDD_FREQUENT_SAVE_FEATURE
-        filter_flat_mdd(instance, *refining_mdd, true);
+        filter_flat_mdd(instance, *refining_mdd, flat_writeback, true);
 #endif
 
-        if (temporaries::lower_bound >= instance.shared_object->upper_bound) {
+        if (context.lower_bound >= instance.shared_object->upper_bound) {
             instance.shared_object->is_mdd_reduction_complete = true;
             return;
         }
+        if (is_reduction_stopped(instance, *mdd_node_source, trial_workspace, stop_token)) {
+            filter_flat_mdd(instance, *refining_mdd, flat_writeback, true);
+            return;
+        }
+    }
+    if (refining_mdd->is_relaxed) {
+        // paths of merged nodes may repeat a character, so the next round refines the reduced flat mdd again
+        std::cout << "Relaxed mdd refined by all characters." << std::endl;
+        filter_flat_mdd(instance, *refining_mdd, flat_writeback, false);
+        return;
     }
     instance.shared_object->is_mdd_reduction_complete = true;
     make_only_one_best_solution_remaining(*mdd_node_source, *refining_mdd);
-    filter_flat_mdd(instance, *refining_mdd, false);
+    filter_flat_mdd(instance, *refining_mdd, flat_writeback, false);
 }
 
 void make_only_one_best_solution_remaining(
@@ -162,6 +212,26 @@ void make_only_one_best_solution_remaining(
                 mdd_node_source.clear_node(node);
             }
         }
-        std::erase_if(level->nodes, [](auto *node) { return !node->is_active; });
+        level->remove_nodes_if([](auto *node) { return !node->is_active; });
+    }
+}
+
+bool is_reduction_stopped(const instance &instance,
+                          const mdd_node_source &mdd_node_source,
+                          const character_selection_workspace &trial_workspace,
+                          const std::stop_token &stop_token) {
+    auto memory_consumption = mdd_node_source.get_memory_consumption();
+    for (const auto &worker: trial_workspace.workers) {
+        memory_consumption += worker.node_source->get_memory_consumption();
+    }
+    auto &shared_object = *instance.shared_object;
+    shared_object.mdd_memory_consumption = std::max(shared_object.mdd_memory_consumption,
+                                                    static_cast<long>(memory_consumption / 1024));
+    if (constants::mdd_memory_limit > 0
+        && memory_consumption > static_cast<std::size_t>(constants::mdd_memory_limit) * 1024 * 1024) {
+        std::cout << "Mdd reduction reached its memory limit of " << constants::mdd_memory_limit << "MB." << std::endl;
+        shared_object.is_memory_limit_reached = true;
+        return true;
     }
+    return stop_token.stop_requested();
 }
@@ -1,33 +1,53 @@
 #include "header/mdd_refinement.hpp"
+#include "header/mdd_merging.hpp"
+#include "../constants.hpp"
 
 #include <ranges>
 
 void refine_mdd_level(level_type &level,
                       Character split_character,
-                      mdd_node_source &mdd_node_source);
+                      mdd_node_source &mdd_node_source,
+                      solver_context &context);
 
 void split_node(node *node_yes_no,
                 Character split_character,
                 level_type &level,
-                mdd_node_source &mdd_node_source);
+                mdd_node_source &mdd_node_source,
+                const solver_context &context);
 
-void refine_mdd(const mdd &mdd, const Character split_character,
-                mdd_node_source &mdd_node_source) {
+void refine_mdd(mdd &mdd, const Character split_character,
+                mdd_node_source &mdd_node_source,
+                solver_context &context) {
+    refine_mdd(mdd, std::span(&split_character, 1), mdd_node_source, context);
+}
+
+void refine_mdd(mdd &mdd, const std::span<const Character> split_characters,
+                mdd_node_source &mdd_node_source,
+                solver_context &context) {
+    // level by level, so the preds of a level are already split by every character of the batch
     for (const auto &level: mdd.levels | std::views::drop(1)) {
-        refine_mdd_level(*level, split_character, mdd_node_source);
+        for (const auto split_character: split_characters) {
+            refine_mdd_level(*level, split_character, mdd_node_source, context);
+        }
+        if (constants::max_level_width > 0
+            && relax_level(*level, static_cast<std::size_t>(constants::max_level_width), mdd_node_source, context.scratch)) {
+            mdd.is_relaxed = true;
+        }
     }
 }
 
 void refine_mdd_level(level_type &level,
                       const Character split_character,
-                      mdd_node_source &mdd_node_source) {
-    static auto nodes = std::vector<node *>();
+                      mdd_node_source &mdd_node_source,
+                      solver_context &context) {
+    auto &nodes = context.scratch.level_nodes;
     nodes.resize(level.nodes.size());
     std::ranges::copy(level.nodes, nodes.begin());
     for (const auto node: nodes) {
-        if (node->characters_on_paths_to_root.test(split_character)
+        if (node->is_active
+            && node->characters_on_paths_to_root.test(split_character)
             && node->characters_on_paths_to_some_sink.test(split_character)) {
-            split_node(node, split_character, level, mdd_node_source);
+            split_node(node, split_character, level, mdd_node_source, context);
         }
     }
 }
@@ -35,7 +55,9 @@ void refine_mdd_level(level_type &level,
 inline void split_node(node *node_yes_no,
                        const Character split_character,
                        level_type &level,
-                       mdd_node_source &mdd_node_source) {
+                       mdd_node_source &mdd_node_source,
+                       const solver_context &context) {
+    node_yes_no->record_for_undo();
     node *node_no_maybe = mdd_node_source.get_copy_of_old_node(*node_yes_no);
     node_no_maybe->characters_on_paths_to_root.reset(split_character);
     node_no_maybe->characters_on_all_paths_to_root.reset(split_character);
@@ -44,40 +66,37 @@ inline void split_node(node *node_yes_no,
     node_yes_no->characters_on_all_paths_to_root.set(split_character);
 
     node_yes_no->notify_relatives_of_update();
-    node_yes_no->needs_update_from_succ = true;
-    node_yes_no->needs_update_from_pred = true;
+    node_yes_no->mark_for_update_from_succ();
+    node_yes_no->mark_for_update_from_pred();
     node_no_maybe->needs_update_from_succ = true;
     node_no_maybe->needs_update_from_pred = true;
 
-    auto static edges_in_copy = std::vector<node *>();
-    edges_in_copy.resize(node_yes_no->edges_in.size());
-    std::ranges::copy(node_yes_no->edges_in, edges_in_copy.begin());
-    for (const auto pred: edges_in_copy) {
-        if (!pred->characters_on_all_paths_to_root.test(split_character)) {
+    // backwards, so the edges swapped in by an unlink are already visited
+    for (auto in_index = node_yes_no->edges_in.size(); in_index-- > 0;) {
+        if (const auto pred = node_yes_no->edges_in[in_index];
+            !pred->characters_on_all_paths_to_root.test(split_character)) {
             pred->link_pred_to_succ(node_no_maybe);
-            pred->unlink_pred_from_succ(node_yes_no);
+            node_yes_no->unlink_in_edge(in_index);
         }
     }
 
-    auto static edges_out_copy = std::vector<node *>();
-    edges_out_copy.resize(node_yes_no->edges_out.size());
-    std::ranges::copy(node_yes_no->edges_out, edges_out_copy.begin());
-    for (const auto succ: edges_out_copy) {
+    for (auto out_index = node_yes_no->edges_out.size(); out_index-- > 0;) {
+        const auto succ = node_yes_no->edges_out[out_index];
         node_no_maybe->link_pred_to_succ(succ);
         if (succ->characters_on_all_paths_to_lower_bound_levels.test(split_character) || succ->character == split_character) {
-            node_yes_no->unlink_pred_from_succ(succ);
+            node_yes_no->unlink_out_edge(out_index);
         }
     }
 
     if (node_no_maybe->edges_in.empty() ||
-        (node_no_maybe->edges_out.empty() && level.depth <= temporaries::lower_bound)) {
+        (node_no_maybe->edges_out.empty() && level.depth <= context.lower_bound)) {
         mdd_node_source.clear_node(node_no_maybe);
     } else {
-        level.nodes.push_back(node_no_maybe);
+        level.add_node(node_no_maybe);
     }
 
     if (node_yes_no->edges_in.empty()
-        || (node_yes_no->edges_out.empty() && level.depth <= temporaries::lower_bound)
+        || (node_yes_no->edges_out.empty() && level.depth <= context.lower_bound)
         || static_cast<int>(node_yes_no->characters_on_all_paths_to_root.count()) > level.depth) {
         node_yes_no->deactivate();
     }
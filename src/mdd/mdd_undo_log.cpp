@@ -0,0 +1,145 @@
+#include "mdd_undo_log.hpp"
+
+#include <ranges>
+
+void record_node_for_undo(mdd_undo_log &undo_log, node &node) {
+    undo_log.record_node(node);
+}
+
+void record_level_for_undo(mdd_undo_log &undo_log, level_type &level) {
+    undo_log.record_level(level);
+}
+
+void record_created_node_for_undo(mdd_undo_log &undo_log, node &node) {
+    undo_log.record_created_node(node);
+}
+
+void mdd_undo_log::begin_trial(const mdd &mdd, mdd_node_source &mdd_node_source) {
+    node_snapshots.clear();
+    saved_edges.clear();
+    saved_edge_positions.clear();
+    number_of_level_snapshots = 0;
+    dropped_levels.clear();
+    created_nodes.clear();
+    was_relaxed = mdd.is_relaxed;
+    levels.clear();
+    for (const auto &level: mdd.levels) {
+        levels.push_back(level.get());
+        level->dirty_nodes.undo_log = this;
+    }
+    mdd_node_source.undo_log = this;
+}
+
+void mdd_undo_log::roll_back(mdd &mdd, mdd_node_source &mdd_node_source) {
+    mdd_node_source.undo_log = nullptr;
+    for (const auto created_node: created_nodes) {
+        // its relatives are restored below or created by the trial as well
+        created_node->clear_edges();
+        created_node->detach_from_level();
+        created_node->is_recorded_for_undo = false;
+        created_node->is_active = false;
+        mdd_node_source.recycle_node(created_node);
+    }
+
+    for (std::size_t snapshot_index = 0; snapshot_index < node_snapshots.size(); ++snapshot_index) {
+        const auto &snapshot = node_snapshots[snapshot_index];
+        auto &original = *snapshot.original;
+        original.characters_on_paths_to_root = saved_character_sets[4 * snapshot_index];
+        original.characters_on_all_paths_to_root = saved_character_sets[4 * snapshot_index + 1];
+        original.characters_on_paths_to_some_sink = saved_character_sets[4 * snapshot_index + 2];
+        original.characters_on_all_paths_to_lower_bound_levels = saved_character_sets[4 * snapshot_index + 3];
+        const auto first_edge_out = saved_edges.begin() + static_cast<long>(snapshot.first_edge);
+        const auto first_edge_in = first_edge_out + static_cast<long>(snapshot.number_of_edges_out);
+        const auto end_edge_in = first_edge_in + static_cast<long>(snapshot.number_of_edges_in);
+        original.edges_out.assign(first_edge_out, first_edge_in);
+        original.edges_in.assign(first_edge_in, end_edge_in);
+        const auto first_position_out = saved_edge_positions.begin() + static_cast<long>(snapshot.first_edge);
+        const auto first_position_in = first_position_out + static_cast<long>(snapshot.number_of_edges_out);
+        const auto end_position_in = first_position_in + static_cast<long>(snapshot.number_of_edges_in);
+        original.edges_out_positions.assign(first_position_out, first_position_in);
+        original.edges_in_positions.assign(first_position_in, end_position_in);
+        original.dirty_nodes = snapshot.dirty_nodes;
+        original.associated_match = snapshot.associated_match;
+        original.upper_bound_down = snapshot.upper_bound_down;
+        original.needs_update_from_pred = snapshot.needs_update_from_pred;
+        original.needs_update_from_succ = snapshot.needs_update_from_succ;
+        original.is_queued_from_pred = snapshot.is_queued_from_pred;
+        original.is_queued_from_succ = snapshot.is_queued_from_succ;
+        original.is_active = snapshot.is_active;
+        original.is_recorded_for_undo = false;
+    }
+
+    for (auto &snapshot: level_snapshots | std::views::take(number_of_level_snapshots)) {
+        std::swap(snapshot.original->nodes, snapshot.nodes);
+        snapshot.original->renumber_nodes();
+        snapshot.original->is_recorded_for_undo = false;
+    }
+
+    // levels are only dropped within a trial, so the levels of the mdd are a subsequence of the recorded ones
+    for (auto &level: mdd.levels) {
+        static_cast<void>(level.release());
+    }
+    for (auto &level: dropped_levels) {
+        static_cast<void>(level.release());
+    }
+    mdd.levels.clear();
+    for (const auto level: levels) {
+        mdd.levels.emplace_back(level);
+        level->needs_pruning = false;
+        level->dirty_nodes.from_pred.clear();
+        level->dirty_nodes.from_succ.clear();
+        level->dirty_nodes.undo_log = nullptr;
+    }
+    dropped_levels.clear();
+    mdd.is_relaxed = was_relaxed;
+}
+
+void mdd_undo_log::record_node(node &node) {
+    node.is_recorded_for_undo = true;
+    const auto character_set_index = 4 * node_snapshots.size();
+    if (saved_character_sets.size() < character_set_index + 4) {
+        saved_character_sets.resize(character_set_index + 4);
+    }
+    saved_character_sets[character_set_index] = node.characters_on_paths_to_root;
+    saved_character_sets[character_set_index + 1] = node.characters_on_all_paths_to_root;
+    saved_character_sets[character_set_index + 2] = node.characters_on_paths_to_some_sink;
+    saved_character_sets[character_set_index + 3] = node.characters_on_all_paths_to_lower_bound_levels;
+
+    node_snapshots.push_back(node_snapshot{
+        .original = &node,
+        .first_edge = saved_edges.size(),
+        .number_of_edges_out = node.edges_out.size(),
+        .number_of_edges_in = node.edges_in.size(),
+        .dirty_nodes = node.dirty_nodes,
+        .associated_match = node.associated_match,
+        .upper_bound_down = node.upper_bound_down,
+        .needs_update_from_pred = node.needs_update_from_pred,
+        .needs_update_from_succ = node.needs_update_from_succ,
+        .is_queued_from_pred = node.is_queued_from_pred,
+        .is_queued_from_succ = node.is_queued_from_succ,
+        .is_active = node.is_active
+    });
+    saved_edges.insert(saved_edges.end(), node.edges_out.begin(), node.edges_out.end());
+    saved_edges.insert(saved_edges.end(), node.edges_in.begin(), node.edges_in.end());
+    saved_edge_positions.insert(saved_edge_positions.end(), node.edges_out_positions.begin(), node.edges_out_positions.end());
+    saved_edge_positions.insert(saved_edge_positions.end(), node.edges_in_positions.begin(), node.edges_in_positions.end());
+}
+
+void mdd_undo_log::record_level(level_type &level) {
+    level.is_recorded_for_undo = true;
+    if (level_snapshots.size() == number_of_level_snapshots) {
+        level_snapshots.emplace_back();
+    }
+    auto &snapshot = level_snapshots[number_of_level_snapshots++];
+    snapshot.original = &level;
+    snapshot.nodes = level.nodes;
+}
+
+void mdd_undo_log::record_created_node(node &node) {
+    node.is_recorded_for_undo = true;
+    created_nodes.push_back(&node);
+}
+
+void mdd_undo_log::keep_dropped_level(std::unique_ptr<level_type> &&level) {
+    dropped_levels.push_back(std::move(level));
+}
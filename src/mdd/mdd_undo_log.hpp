@@ -0,0 +1,60 @@
+#pragma once
+
+#include "mdd.hpp"
+
+#include <memory>
+#include <vector>
+
+/*
+ * Journal of a trial on an mdd, e.g. refining and filtering it by a candidate split character.
+ * Nodes and levels are saved before their first change, the nodes created by the trial are tracked by the node source
+ * and dropped levels are kept alive, so roll_back restores the mdd in time proportional to the changed region.
+ * The trial has to run on a single thread.
+ */
+struct mdd_undo_log {
+
+private:
+    struct node_snapshot {
+        node *original = nullptr;
+        std::size_t first_edge = 0; // in saved_edges and saved_edge_positions, out edges before in edges
+        std::size_t number_of_edges_out = 0;
+        std::size_t number_of_edges_in = 0;
+        dirty_nodes_type *dirty_nodes = nullptr;
+        void *associated_match = nullptr;
+        int upper_bound_down = 0;
+        bool needs_update_from_pred = false;
+        bool needs_update_from_succ = false;
+        bool is_queued_from_pred = false;
+        bool is_queued_from_succ = false;
+        bool is_active = false;
+    };
+
+    struct level_snapshot {
+        level_type *original = nullptr;
+        level_nodes_type nodes = level_nodes_type();
+    };
+
+    std::vector<node_snapshot> node_snapshots = std::vector<node_snapshot>();
+    std::vector<Character_set> saved_character_sets = std::vector<Character_set>(); // four per node snapshot
+    std::vector<node *> saved_edges = std::vector<node *>();
+    std::vector<unsigned int> saved_edge_positions = std::vector<unsigned int>();
+    std::vector<level_snapshot> level_snapshots = std::vector<level_snapshot>(); // reused beyond number_of_level_snapshots
+    std::size_t number_of_level_snapshots = 0;
+    std::vector<level_type *> levels = std::vector<level_type *>(); // of the mdd when the trial began
+    std::vector<std::unique_ptr<level_type> > dropped_levels = std::vector<std::unique_ptr<level_type> >();
+    std::vector<node *> created_nodes = std::vector<node *>();
+    bool was_relaxed = false;
+
+public:
+    void begin_trial(const mdd &mdd, mdd_node_source &mdd_node_source);
+
+    void roll_back(mdd &mdd, mdd_node_source &mdd_node_source);
+
+    void record_node(node &node);
+
+    void record_level(level_type &level);
+
+    void record_created_node(node &node);
+
+    void keep_dropped_level(std::unique_ptr<level_type> &&level);
+};
@@ -0,0 +1,153 @@
+#include "header/restricted_mdd.hpp"
+#include "../config.hpp"
+#include "../constants.hpp"
+#include "absl/container/flat_hash_map.h"
+
+#include <algorithm>
+#include <vector>
+
+struct restricted_node {
+    const rflcs_graph::match *match = nullptr;
+    Character_set used_characters = Character_set(); // including the match character
+    int pred_index = -1; // in the previous level
+};
+
+struct restricted_candidate {
+    const rflcs_graph::match *match = nullptr;
+    int pred_index = 0;
+    int score = 0; // depth plus a bound on the remaining length
+};
+
+typedef std::vector<std::vector<restricted_node> > restricted_levels_type;
+
+int build_restricted_mdd(const std::stop_token &stop_token,
+                         const instance &instance,
+                         std::size_t max_width,
+                         int lower_bound,
+                         restricted_levels_type &levels);
+
+void collect_candidates(const std::vector<restricted_node> &level,
+                        int depth,
+                        int lower_bound,
+                        std::vector<restricted_candidate> &candidates,
+                        Character_set &temp_character_set);
+
+std::vector<Character> extract_solution(const restricted_levels_type &levels);
+
+void solve_by_restricted_mdd(const std::stop_token stop_token,
+                             const instance &instance,
+                             const int upper_bound,
+                             restricted_mdd_result &result) {
+    auto levels = restricted_levels_type();
+    int lower_bound;
+    {
+        auto lock = std::scoped_lock(result.mutex);
+        lower_bound = result.lower_bound;
+    }
+
+    for (std::size_t max_width = RESTRICTED_MDD_INITIAL_WIDTH;
+         max_width <= RESTRICTED_MDD_MAX_WIDTH && lower_bound < upper_bound && !stop_token.stop_requested();
+         max_width *= 2) {
+        if (const auto depth = build_restricted_mdd(stop_token, instance, max_width, lower_bound, levels);
+            depth > lower_bound) {
+            lower_bound = depth;
+            auto lock = std::scoped_lock(result.mutex);
+            if (depth > result.lower_bound) {
+                result.lower_bound = depth;
+                result.solution = extract_solution(levels);
+            }
+        }
+    }
+}
+
+// returns the depth of the deepest level, which is the length of the best path
+int build_restricted_mdd(const std::stop_token &stop_token,
+                         const instance &instance,
+                         const std::size_t max_width,
+                         const int lower_bound,
+                         restricted_levels_type &levels) {
+    levels.clear();
+    levels.emplace_back().push_back(restricted_node{.match = &instance.graph->matches.front()});
+
+    auto candidates = std::vector<restricted_candidate>();
+    auto temp_character_set = Character_set();
+    auto nodes_of_match = absl::flat_hash_map<const rflcs_graph::match *, std::vector<int> >();
+    int depth = 0;
+    while (!stop_token.stop_requested()) {
+        // only paths which may still beat the lower bound are extended
+        collect_candidates(levels[depth], depth, lower_bound, candidates, temp_character_set);
+        if (candidates.empty()) {
+            break;
+        }
+        std::ranges::stable_sort(candidates, std::greater(), &restricted_candidate::score);
+
+        levels.emplace_back();
+        const auto &level = levels[depth];
+        auto &next_level = levels[depth + 1];
+        nodes_of_match.clear();
+        for (const auto &[match, pred_index, score]: candidates) {
+            if (next_level.size() == max_width) {
+                break;
+            }
+            temp_character_set = level[pred_index].used_characters;
+            temp_character_set.set(match->character);
+            auto &same_match_nodes = nodes_of_match[match];
+            if (std::ranges::any_of(same_match_nodes, [&](const int node_index) {
+                return next_level[node_index].used_characters == temp_character_set;
+            })) {
+                continue;
+            }
+            same_match_nodes.push_back(static_cast<int>(next_level.size()));
+            next_level.push_back(restricted_node{
+                .match = match,
+                .used_characters = temp_character_set,
+                .pred_index = pred_index
+            });
+        }
+        ++depth;
+    }
+    return depth;
+}
+
+void collect_candidates(const std::vector<restricted_node> &level,
+                        const int depth,
+                        const int lower_bound,
+                        std::vector<restricted_candidate> &candidates,
+                        Character_set &temp_character_set) {
+    candidates.clear();
+    for (int node_index = 0; node_index < static_cast<int>(level.size()); ++node_index) {
+        const auto &[match, used_characters, pred_index] = level[node_index];
+        for (const auto succ_match: match->extension->succ_matches) {
+            if (succ_match->character >= constants::alphabet_size
+                || !succ_match->is_active
+                || used_characters.test(succ_match->character)) {
+                continue;
+            }
+            const auto &available_characters = succ_match->extension->available_characters;
+            temp_character_set = available_characters;
+            temp_character_set &= used_characters;
+            const auto unused_available_characters =
+                    static_cast<int>(available_characters.count() - temp_character_set.count());
+            // the match character is available, but counted by the depth
+            const auto score = depth + 1 + std::min(succ_match->upper_bound, unused_available_characters) - 1;
+            if (score > lower_bound) {
+                candidates.push_back(restricted_candidate{
+                    .match = succ_match,
+                    .pred_index = node_index,
+                    .score = score
+                });
+            }
+        }
+    }
+}
+
+std::vector<Character> extract_solution(const restricted_levels_type &levels) {
+    auto solution = std::vector<Character>(levels.size() - 1);
+    auto node_index = 0;
+    for (auto depth = levels.size() - 1; depth > 0; --depth) {
+        const auto &node = levels[depth][node_index];
+        solution[depth - 1] = node.match->character;
+        node_index = node.pred_index;
+    }
+    return solution;
+}
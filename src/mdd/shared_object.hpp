@@ -2,45 +2,174 @@
 
 #include "mdd.hpp"
 
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
 struct instance;
 struct shared_object;
+struct scratch_space;
 
 size_t calculate_shared_object_size(const mdd& data);
 
-void serialize_initial_mdd(const mdd& mdd, shared_object* shared_object);
+void serialize_initial_mdd(const mdd& mdd, shared_object* shared_object, scratch_space& scratch);
 
-int get_active_match_count(shared_object* flat_mdd);
+int get_active_match_count(shared_object* flat_mdd, scratch_space& scratch);
 
 int get_active_edge_count(shared_object* flat_mdd);
 
-struct flat_node;
+typedef std::uint64_t flat_activity_word;
+
+constexpr std::uint32_t FLAT_ACTIVITY_WORD_BITS = 64;
 
 struct flat_edge {
-    flat_node* edge_node;
-    bool is_active;
+    std::uint32_t node_index; // in the nodes of the flat mdd
 };
 
 struct flat_node {
-    void* match_ptr;
+    int match_id;
     Character character;
     int position_2;
-    bool is_active;
-    size_t num_edges_out;
-    flat_edge edges_out[];
+    std::uint32_t first_edge; // in the edges of the flat mdd, the edges of a node are consecutive
+    std::uint32_t num_edges_out;
 };
 
 struct flat_level {
     int depth;
-    size_t num_nodes;
-    flat_node nodes[];
+    std::uint32_t first_node; // in the nodes of the flat mdd, the nodes of a level are consecutive
+    std::uint32_t num_nodes;
+};
+
+// byte offsets of the arrays of the flat mdd, which follow each other in this order behind the shared object
+struct flat_mdd_layout {
+    std::size_t level_capacity = 0;
+    std::uint32_t num_nodes = 0;
+    std::uint32_t num_edges = 0;
+    std::size_t nodes_offset = 0;
+    std::size_t edges_offset = 0;
+    std::size_t node_activity_offset = 0;
+    std::size_t edge_activity_offset = 0;
+    std::size_t size = 0;
+};
+
+// the size only grows with each of the counts, so a smaller mdd fits into the space of a larger one
+flat_mdd_layout calculate_flat_mdd_layout(std::size_t num_levels, std::size_t num_nodes, std::size_t num_edges);
+
+constexpr int NO_SUCC_MATCH_ID = -1;
+
+// a flat node, or a flat edge to the successor match, which lost its last counterpart in the refined mdd
+struct flat_delta {
+    int depth;
+    int match_id;
+    int succ_match_id; // NO_SUCC_MATCH_ID for a node
+};
+
+constexpr std::uint64_t FLAT_DELTA_LOG_CAPACITY = 1 << 16;
+
+/*
+ * Ring buffer of the deactivations of the flat mdd, written by the reduction child and read by the parent,
+ * which prunes its mdd by them instead of rescanning the whole flat mdd after the round.
+ * There is a single writer and a single reader, a full buffer makes the writer wait for the reader.
+ */
+struct flat_delta_log {
+    std::atomic<std::uint64_t> write_count = 0;
+    std::atomic<std::uint64_t> read_count = 0;
+    flat_delta deltas[FLAT_DELTA_LOG_CAPACITY];
+
+    void reset() {
+        write_count.store(0);
+        read_count.store(0);
+    }
+
+    void append(const flat_delta &delta);
+
+    // appends the deltas written since the last drain
+    void drain(std::vector<flat_delta> &drained_deltas);
 };
 
+/*
+ * Levels, nodes and edges refer to each other by 32-bit indices and matches by their id,
+ * the activity of nodes and edges is kept in bitmaps, so scans only touch a few bytes per entry.
+ * The layout is set by serialize_initial_mdd, afterwards only bits are cleared and levels dropped at the end.
+ */
 struct shared_object {
     int upper_bound = std::numeric_limits<int>::max();
     int active_match_count = std::numeric_limits<int>::max();
     int number_of_refined_characters = 0;
     int refinement_round = 1;
     bool is_mdd_reduction_complete = false;
+    bool is_memory_limit_reached = false;
+    long mdd_memory_consumption = 0; // peak of the node sources of the reduction rounds in KB
     size_t num_levels = std::numeric_limits<int>::max();
-    flat_level flat_levels[];
+    flat_mdd_layout layout = flat_mdd_layout();
+    flat_delta_log delta_log = flat_delta_log();
+    alignas(flat_activity_word) std::byte flat_mdd[];
+
+    flat_level *levels() {
+        return std::bit_cast<flat_level *>(&flat_mdd[0]);
+    }
+
+    flat_node *nodes() {
+        return std::bit_cast<flat_node *>(&flat_mdd[layout.nodes_offset]);
+    }
+
+    flat_edge *edges() {
+        return std::bit_cast<flat_edge *>(&flat_mdd[layout.edges_offset]);
+    }
+
+    flat_activity_word *node_activity() {
+        return std::bit_cast<flat_activity_word *>(&flat_mdd[layout.node_activity_offset]);
+    }
+
+    flat_activity_word *edge_activity() {
+        return std::bit_cast<flat_activity_word *>(&flat_mdd[layout.edge_activity_offset]);
+    }
+
+    [[nodiscard]] const flat_level *levels() const {
+        return const_cast<shared_object *>(this)->levels();
+    }
+
+    [[nodiscard]] const flat_node *nodes() const {
+        return const_cast<shared_object *>(this)->nodes();
+    }
+
+    [[nodiscard]] const flat_edge *edges() const {
+        return const_cast<shared_object *>(this)->edges();
+    }
+
+    [[nodiscard]] bool is_node_active(const std::uint32_t node_index) const {
+        return test_activity(const_cast<shared_object *>(this)->node_activity(), node_index);
+    }
+
+    [[nodiscard]] bool is_edge_active(const std::uint32_t edge_index) const {
+        return test_activity(const_cast<shared_object *>(this)->edge_activity(), edge_index);
+    }
+
+    void deactivate_node(const std::uint32_t node_index) {
+        reset_activity(node_activity(), node_index);
+    }
+
+    void deactivate_edge(const std::uint32_t edge_index) {
+        reset_activity(edge_activity(), edge_index);
+    }
+
+    // nodes and edges of the levels which are still in use, levels are only dropped at the end
+    [[nodiscard]] std::uint32_t num_used_nodes() const {
+        return num_levels < layout.level_capacity ? levels()[num_levels].first_node : layout.num_nodes;
+    }
+
+    [[nodiscard]] std::uint32_t num_used_edges() const {
+        const auto node_end = num_used_nodes();
+        return node_end < layout.num_nodes ? nodes()[node_end].first_edge : layout.num_edges;
+    }
+
+private:
+    static bool test_activity(const flat_activity_word *words, const std::uint32_t index) {
+        return (words[index / FLAT_ACTIVITY_WORD_BITS] >> index % FLAT_ACTIVITY_WORD_BITS) & 1;
+    }
+
+    static void reset_activity(flat_activity_word *words, const std::uint32_t index) {
+        words[index / FLAT_ACTIVITY_WORD_BITS] &= ~(flat_activity_word{1} << index % FLAT_ACTIVITY_WORD_BITS);
+    }
 };
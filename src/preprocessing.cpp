@@ -0,0 +1,273 @@
+#include "preprocessing.hpp"
+#include "constants.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <ranges>
+#include <vector>
+
+void collapse_runs(std::vector<Character> &string);
+
+auto try_force_character(instance &instance, Character character) -> bool;
+
+void remap_string(std::vector<Character> &string, const std::vector<Character> &compact_characters);
+
+void remap_next_occurrences(int_matrix &next_occurrences, const std::vector<Character> &compact_characters);
+
+void remap_matches(std::vector<rflcs_graph::match> &matches,
+                   const std::vector<Character> &live_characters,
+                   const std::vector<Character> &compact_characters);
+
+void report_character_set_size();
+
+/*
+ * If both strings start with the same character, some optimal solution starts with it:
+ * any other occurrence in a solution can be moved to the front. The character is therefore fixed
+ * as a solution prefix and removed from both strings entirely. The same holds for common last characters.
+ * Runs of a repeated character are collapsed to one occurrence, since a solution uses it at most once.
+ */
+void kernelize_strings(instance &instance) {
+    auto &string_1 = instance.string_1;
+    auto &string_2 = instance.string_2;
+    const auto original_length_1 = string_1.size();
+    const auto original_length_2 = string_2.size();
+    collapse_runs(string_1);
+    collapse_runs(string_2);
+
+    bool is_changed = true;
+    while (is_changed && !string_1.empty() && !string_2.empty()) {
+        is_changed = false;
+        if (const auto character = string_1.front(); character == string_2.front()
+                                                     && try_force_character(instance, character)) {
+            instance.forced_prefix.push_back(character);
+            is_changed = true;
+        }
+        if (const auto character = string_1.back(); character == string_2.back()
+                                                    && try_force_character(instance, character)) {
+            instance.forced_suffix.push_back(character);
+            is_changed = true;
+        }
+    }
+
+    if (string_1.size() < original_length_1 || string_2.size() < original_length_2) {
+        std::cout << "Kernelization shortened strings from " << original_length_1 << "/" << original_length_2
+                << " to " << string_1.size() << "/" << string_2.size() << ", forced "
+                << instance.forced_prefix.size() + instance.forced_suffix.size() << " characters." << std::endl;
+    }
+}
+
+void collapse_runs(std::vector<Character> &string) {
+    const auto [first, last] = std::ranges::unique(string);
+    string.erase(first, last);
+}
+
+auto try_force_character(instance &instance, const Character character) -> bool {
+    // the remaining instance has to stay non-empty for graph creation
+    if (std::ranges::count(instance.string_1, character) == static_cast<long>(instance.string_1.size())
+        || std::ranges::count(instance.string_2, character) == static_cast<long>(instance.string_2.size())) {
+        return false;
+    }
+    std::erase(instance.string_1, character);
+    std::erase(instance.string_2, character);
+    collapse_runs(instance.string_1);
+    collapse_runs(instance.string_2);
+    return true;
+}
+
+/*
+ * Characters that occur in only one of the strings cannot be part of any common subsequence.
+ * They are removed from both strings and the remaining characters are renumbered densely,
+ * so every character set and per character vector is sized by the live alphabet only.
+ */
+PROCESSING_STATUS_CODE reduce_alphabet(instance &instance) {
+    auto occurs_in_string_1 = std::vector<bool>(constants::alphabet_size);
+    auto occurs_in_string_2 = std::vector<bool>(constants::alphabet_size);
+    for (const auto character: instance.string_1) {
+        occurs_in_string_1[character] = true;
+    }
+    for (const auto character: instance.string_2) {
+        occurs_in_string_2[character] = true;
+    }
+
+    auto compact_characters = std::vector<Character>(constants::alphabet_size, MAX_CHARACTER);
+    instance.original_characters.clear();
+    for (int character = 0; character < constants::alphabet_size; character++) {
+        if (occurs_in_string_1[character] && occurs_in_string_2[character]) {
+            compact_characters[character] = static_cast<Character>(instance.original_characters.size());
+            instance.original_characters.push_back(character);
+        }
+    }
+
+    const auto live_alphabet_size = static_cast<int>(instance.original_characters.size());
+    if (live_alphabet_size == 0) {
+        std::cout << "Strings have no common character, keeping the declared alphabet." << std::endl;
+        instance.original_characters.clear();
+        return SUCCESS;
+    }
+
+    if (live_alphabet_size < constants::alphabet_size) {
+        remap_string(instance.string_1, compact_characters);
+        remap_string(instance.string_2, compact_characters);
+        std::cout << "Alphabet reduced from " << constants::alphabet_size << " to " << live_alphabet_size
+                << " characters." << std::endl;
+        constants::alphabet_size = live_alphabet_size;
+        instance.context.upper_bound = std::min(instance.context.upper_bound, live_alphabet_size);
+    }
+
+#ifdef CHARACTER_SET_SIZE
+    if (constants::alphabet_size > CHARACTER_SET_SIZE) {
+        std::cout << "Alphabet size " << constants::alphabet_size << " exceeds the character set size "
+                << CHARACTER_SET_SIZE << " of this build." << std::endl;
+        instance.input_validity_code = 1;
+        return INPUT_FILE_ERROR;
+    }
+#endif
+    report_character_set_size();
+    return SUCCESS;
+}
+
+void report_character_set_size() {
+#ifdef CHARACTER_SET_SIZE
+    if (const auto sufficient_size = std::bit_ceil(static_cast<unsigned>(constants::alphabet_size));
+        sufficient_size < CHARACTER_SET_SIZE) {
+        std::cout << "A build with character set size " << sufficient_size << " is sufficient." << std::endl;
+    }
+#endif
+}
+
+void reduce_alphabet_by_graph(instance &instance) {
+    if (instance.context.lower_bound >= instance.context.upper_bound) {
+        return;
+    }
+    auto is_live = std::vector<bool>(constants::alphabet_size);
+    for (const auto &match: instance.graph->matches) {
+        if (match.is_active && match.character < constants::alphabet_size) {
+            is_live[match.character] = true;
+        }
+    }
+    auto live_characters = std::vector<Character>();
+    for (int character = 0; character < constants::alphabet_size; character++) {
+        if (is_live[character]) {
+            live_characters.push_back(character);
+        }
+    }
+    if (live_characters.empty() || static_cast<int>(live_characters.size()) == constants::alphabet_size) {
+        return;
+    }
+    std::cout << "Reduced graph uses " << live_characters.size() << " of " << constants::alphabet_size
+            << " characters." << std::endl;
+    compact_alphabet(instance, live_characters);
+    report_character_set_size();
+}
+
+/*
+ * The live characters are renumbered densely from 0 and the others follow them, so the strings, their next occurrences
+ * and a solution with other characters keep a valid numbering. The matches of the other characters are deactivated,
+ * and from now on the character sets of the matches and of the context only cover the live characters.
+ */
+void compact_alphabet(instance &instance, const std::vector<Character> &live_characters) {
+    auto compact_characters = std::vector<Character>(constants::alphabet_size, MAX_CHARACTER);
+    for (std::size_t compact_character = 0; compact_character < live_characters.size(); compact_character++) {
+        compact_characters[live_characters[compact_character]] = static_cast<Character>(compact_character);
+    }
+    auto next_compact_character = static_cast<Character>(live_characters.size());
+    for (auto &compact_character: compact_characters) {
+        if (compact_character == MAX_CHARACTER) {
+            compact_character = next_compact_character++;
+        }
+    }
+
+    auto original_characters = std::vector<Character>(constants::alphabet_size);
+    for (int character = 0; character < constants::alphabet_size; character++) {
+        original_characters[compact_characters[character]] = instance.original_characters.empty()
+                                                                  ? character
+                                                                  : instance.original_characters[character];
+    }
+    instance.original_characters = std::move(original_characters);
+
+    for (auto *string: {&instance.string_1, &instance.string_2}) {
+        for (auto &character: *string) {
+            character = compact_characters[character];
+        }
+    }
+    remap_next_occurrences(instance.next_occurrences_1, compact_characters);
+    remap_next_occurrences(instance.next_occurrences_2, compact_characters);
+    for (auto &character: instance.solution) {
+        character = compact_characters[character];
+    }
+
+    constants::alphabet_size = static_cast<int>(live_characters.size());
+    remap_matches(instance.graph->matches, live_characters, compact_characters);
+    remap_matches(instance.graph->reverse_matches, live_characters, compact_characters);
+    instance.context.upper_bound = std::max(instance.context.lower_bound,
+                                            std::min(instance.context.upper_bound, constants::alphabet_size));
+    instance.context.chaining_numbers = std::vector<int>(constants::alphabet_size);
+    instance.context.scratch = scratch_space();
+    instance.context.worker_scratch.clear();
+}
+
+// the rows keep their width, which is the number of characters of the strings
+void remap_next_occurrences(int_matrix &next_occurrences, const std::vector<Character> &compact_characters) {
+    const auto width = compact_characters.size();
+    auto row = std::vector<int>(width);
+    for (auto row_begin = next_occurrences.begin(); row_begin != next_occurrences.end(); row_begin += width) {
+        for (std::size_t character = 0; character < width; character++) {
+            row[compact_characters[character]] = row_begin[character];
+        }
+        std::ranges::copy(row, row_begin);
+    }
+}
+
+// expects the alphabet size of the live characters
+void remap_matches(std::vector<rflcs_graph::match> &matches,
+                   const std::vector<Character> &live_characters,
+                   const std::vector<Character> &compact_characters) {
+    for (auto &[MATCH_BINDINGS()]: matches) {
+        if (character < static_cast<Character>(compact_characters.size())) {
+            character = compact_characters[character];
+            if (character >= constants::alphabet_size) {
+                is_active = false;
+            }
+        }
+        auto available_characters = Character_set();
+        for (std::size_t compact_character = 0; compact_character < live_characters.size(); compact_character++) {
+            if (extension->available_characters.test(live_characters[compact_character])) {
+                available_characters.set(compact_character);
+            }
+        }
+        extension->available_characters = available_characters;
+        extension->repetition_counter.clear();
+        heuristic_characters = Character_set();
+    }
+}
+
+void remap_string(std::vector<Character> &string, const std::vector<Character> &compact_characters) {
+    std::erase_if(string, [&compact_characters](const Character character) {
+        return compact_characters[character] == MAX_CHARACTER;
+    });
+    for (auto &character: string) {
+        character = compact_characters[character];
+    }
+}
+
+void lift_solution(instance &instance) {
+    if (!instance.original_characters.empty()) {
+        for (auto &character: instance.solution) {
+            character = instance.original_characters[character];
+        }
+    }
+
+    for (const auto character: std::ranges::reverse_view(instance.forced_prefix)) {
+        instance.solution.push_front(character);
+    }
+    for (const auto character: std::ranges::reverse_view(instance.forced_suffix)) {
+        instance.solution.push_back(character);
+    }
+    const auto number_of_forced_characters =
+            static_cast<int>(instance.forced_prefix.size() + instance.forced_suffix.size());
+    instance.context.lower_bound += number_of_forced_characters;
+    instance.context.upper_bound += number_of_forced_characters;
+    instance.heuristic_solution_length += number_of_forced_characters;
+    instance.reduction_upper_bound += number_of_forced_characters;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "instance.hpp"
+#include "input_processing.hpp"
+
+void kernelize_strings(instance &instance);
+
+PROCESSING_STATUS_CODE reduce_alphabet(instance &instance);
+
+// drops the characters without active matches once the graph is reduced, before the mdd reduction starts
+void reduce_alphabet_by_graph(instance &instance);
+
+// renumbers the live characters, given in the current numbering, from 0 on
+void compact_alphabet(instance &instance, const std::vector<Character> &live_characters);
+
+void lift_solution(instance &instance);
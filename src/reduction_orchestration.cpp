@@ -1,14 +1,19 @@
+#include "bound_exchange.hpp"
+#include "checkpoint.hpp"
 #include "instance.hpp"
 #include "graph/header/rf_subset_lcs_relaxation.hpp"
 #include "graph/header/simple_upper_bounds.hpp"
 #include "graph/header/match_deactivation.hpp"
+#include "graph/header/match_dominance.hpp"
 #include "graph/header/reduce_graph.hpp"
 #include "mdd/header/initial_mdd.hpp"
 #include "mdd/shared_object.hpp"
 #include "mdd/header/mdd_filter.hpp"
+#include "mdd/mdd_flat_writeback.hpp"
 #include "constants.hpp"
 #include "reduction_orchestration.hpp"
 #include "mdd/header/mdd_reduction.hpp"
+#include "mdd/header/restricted_mdd.hpp"
 #include "absl/container/flat_hash_set.h"
 
 #include <sys/wait.h>
@@ -18,102 +23,258 @@
 #include <csignal>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
 #include <ranges>
 #include <iomanip>
+#include <iterator>
 #include <sys/mman.h>
+#include <thread>
+#include <atomic>
+#include <stop_token>
+#include <limits>
+#include <string>
 #ifdef __linux__
 #include <sys/prctl.h>
 #elif defined(__APPLE__)
 #include <pthread.h>
 #endif
 
-void handle_threads_for_mdd_reduction(instance &instance);
+// one direction of the initial mdd, built with its own node source and context
+struct initial_mdd_build {
+    std::unique_ptr<mdd_node_source> node_source = std::make_unique<mdd_node_source>();
+    solver_context context = solver_context();
+    std::unique_ptr<mdd> built_mdd = nullptr; // nullptr if the build gave up the race
+    long complexity = std::numeric_limits<long>::max();
+};
+
+void build_initial_mdd(const instance &instance, bool forward, initial_mdd_build &build, initial_mdd_race &race);
+
+void create_shared_object(instance &instance);
+
+void run_mdd_reduction_rounds(instance &instance);
+
+bool handle_threads_for_mdd_reduction(instance &instance);
+
+bool is_fitting_max_level_width(const mdd &mdd);
+
+bool run_reduction_round_in_child(instance &instance, std::vector<flat_delta> &deltas);
+
+bool run_reduction_round_in_thread(instance &instance, std::vector<flat_delta> &deltas);
+
+void set_reduction_thread_name();
 
 void set_oom_score_adj(int score);
 
 void filter_matches_by_flat_mdd(instance &instance);
 
-void reduce_graph_pre_solver_by_mdd(instance &instance);
-
 void timeout_handler(int signal);
 
 double get_elapsed_seconds(const instance &instance);
 
 long calculate_mdd_complexity(const mdd &mdd);
 
+void reduce_graph_by_simple_upper_bounds(instance &instance);
+
+void pull_lower_bound_from_heuristic(instance &instance);
+
+void copy_active_successor_lists(const std::vector<rflcs_graph::match> &matches, successor_lists &successor_lists);
+
+void pull_lower_bound_from_restricted_mdd(instance &instance, restricted_mdd_result &restricted_mdd_result);
+
+void stop_restricted_mdd(instance &instance, std::jthread &restricted_mdd_thread, restricted_mdd_result &restricted_mdd_result);
+
+// the heuristic publishes its next bound only after this reduction is done, so no bound is skipped
 void reduce_graph_while_heuristic(instance &instance) {
+    auto &bound_exchange = *instance.bound_exchange;
+    bound_exchange.wait_for_heuristic_ready();
+    int reduced_lower_bound = bound_exchange.reduced_lower_bound.load();
+    while (true) {
+        const long generation = bound_exchange.generation.load();
+        pull_lower_bound_from_heuristic(instance);
+        if (instance.context.lower_bound > reduced_lower_bound) {
+            reduce_graph_by_simple_upper_bounds(instance);
+            publish_reduction_to_heuristic(instance);
+            reduced_lower_bound = instance.context.lower_bound;
+            bound_exchange.publish_reduction_done(reduced_lower_bound);
+        }
+        if (instance.context.lower_bound >= instance.context.upper_bound || bound_exchange.is_heuristic_done) {
+            return;
+        }
+        bound_exchange.generation.wait(generation);
+    }
+}
+
+void reduce_graph_by_simple_upper_bounds(instance &instance) {
     bool is_improving = true;
     while (is_improving) {
-        if (temporaries::lower_bound >= temporaries::upper_bound) {
+        if (instance.context.lower_bound >= instance.context.upper_bound) {
             return;
         }
         is_improving = false;
-        is_improving |= calculate_simple_upper_bounds(*instance.graph);
+        is_improving |= calculate_simple_upper_bounds(*instance.graph, instance.context);
         is_improving |= deactivate_matches(instance);
-        reduce_graph(*instance.graph);
-    }
-    const std::chrono::duration<double> heuristic_elapsed_seconds = std::chrono::system_clock::now() - instance.start;
-    std::cout << std::fixed << std::setprecision(2)
-            << "\n"
-            << "Heuristic found solution with length " << temporaries::lower_bound << ", took "
-            << heuristic_elapsed_seconds.count() << "s. Reducing to " << instance.active_matches << " nodes = "
-            << 100.0 * (1
-                        - static_cast<double>(instance.active_matches)
-                        / static_cast<double>(instance.graph->matches.size() - 2)) << "%."
-            << std::endl;
+        reduce_graph(*instance.graph, instance.context);
+    }
 }
 
 void reduce_graph_pre_solver(instance &instance) {
     bool is_improving = true;
     while (is_improving) {
-        if (temporaries::lower_bound >= temporaries::upper_bound) {
+        if (instance.context.lower_bound >= instance.context.upper_bound) {
             return;
         }
         is_improving = false;
         is_improving |= relax_by_fixed_character_rf_constraint(*instance.graph);
-        is_improving |= calculate_simple_upper_bounds(*instance.graph);
+        is_improving |= calculate_simple_upper_bounds(*instance.graph, instance.context);
         is_improving |= deactivate_matches(instance);
-        reduce_graph(*instance.graph);
+        is_improving |= deactivate_dominated_matches(instance);
+        reduce_graph(*instance.graph, instance.context);
         std::cout << "Repetition-Free Subset LCS Relaxation reduced to " << instance.active_matches << " matches = "
                 << 100.0 * (1 - static_cast<double>(instance.active_matches)
                             / static_cast<double>(instance.graph->matches.size() - 2)) << "%."
+                << " Lower bound: " << instance.context.lower_bound << "."
                 << std::endl;
     }
+}
 
-    instance.mdd_node_source = std::make_unique<mdd_node_source>();
-    return reduce_graph_pre_solver_by_mdd(instance);
+void pull_lower_bound_from_heuristic(instance &instance) {
+    if (instance.bound_exchange != nullptr) {
+        instance.context.lower_bound = std::max(instance.context.lower_bound, instance.bound_exchange->lower_bound.load());
+    }
+}
+
+void publish_reduction_to_heuristic(const instance &instance) {
+    if (instance.bound_exchange == nullptr) {
+        return;
+    }
+    instance.bound_exchange->publish_upper_bound(instance.context.upper_bound);
+    auto snapshot = std::make_shared<reduction_snapshot>();
+    copy_active_successor_lists(instance.graph->matches, snapshot->forward_successors);
+    copy_active_successor_lists(instance.graph->reverse_matches, snapshot->reverse_successors);
+    if (const auto previous_snapshot = instance.bound_exchange->snapshot.load();
+        previous_snapshot == nullptr || *previous_snapshot != *snapshot) {
+        instance.bound_exchange->publish_snapshot(std::move(snapshot));
+    }
+}
+
+void copy_active_successor_lists(const std::vector<rflcs_graph::match> &matches, successor_lists &successor_lists) {
+    successor_lists.offsets.reserve(matches.size() + 1);
+    successor_lists.offsets.push_back(0);
+    for (const auto &match: matches) {
+        if (match.is_active) {
+            std::ranges::copy_if(match.dom_succ_matches, std::back_inserter(successor_lists.successors),
+                                 [](const rflcs_graph::match *succ_match) { return succ_match->is_active; });
+        }
+        successor_lists.offsets.push_back(successor_lists.successors.size());
+    }
 }
 
 void reduce_graph_pre_solver_by_mdd(instance &instance) {
-    auto forward_mdd = create_initial_mdd(instance, true);
-    filter_mdd(instance, *forward_mdd, *instance.mdd_node_source);
-    const long forward_mdd_complexity = calculate_mdd_complexity(*forward_mdd);
-    auto backward_mdd = create_initial_mdd(instance, false);
-    filter_mdd(instance, *backward_mdd, *instance.mdd_node_source);
-    const long backward_mdd_complexity = calculate_mdd_complexity(*backward_mdd);
-
-    instance.is_solving_forward = forward_mdd_complexity < backward_mdd_complexity;
-    std::cout << "Mdd forward complexity: " << forward_mdd_complexity
-            << ", mdd backward complexity: " << backward_mdd_complexity
+    auto race = initial_mdd_race();
+    race.abort_ratio = constants::initial_mdd_abort_ratio;
+    auto forward_build = initial_mdd_build();
+    forward_build.context = instance.context;
+    auto backward_build = initial_mdd_build();
+    backward_build.context = instance.context;
+    {
+        auto backward_thread = std::jthread(build_initial_mdd,
+                                            std::cref(instance),
+                                            false,
+                                            std::ref(backward_build),
+                                            std::ref(race));
+        build_initial_mdd(instance, true, forward_build, race);
+    }
+    for (const auto *build: {&forward_build, &backward_build}) {
+        if (build->built_mdd != nullptr) {
+            instance.context.merge_bounds(build->context);
+        }
+    }
+
+    instance.is_solving_forward = forward_build.complexity < backward_build.complexity;
+    const auto complexity_text = [](const initial_mdd_build &build) {
+        return build.built_mdd == nullptr ? std::string("aborted") : std::to_string(build.complexity);
+    };
+    std::cout << "Mdd forward complexity: " << complexity_text(forward_build)
+            << ", mdd backward complexity: " << complexity_text(backward_build)
             << ". Reduction is using forward problem: "
             << std::boolalpha << instance.is_solving_forward << "." << std::endl;
-    instance.mdd = instance.is_solving_forward ? std::move(forward_mdd) : std::move(backward_mdd);
+    auto &chosen_build = instance.is_solving_forward ? forward_build : backward_build;
+    instance.mdd = std::move(chosen_build.built_mdd);
+    instance.mdd_node_source = std::move(chosen_build.node_source);
 
+    create_shared_object(instance);
+    run_mdd_reduction_rounds(instance);
+}
+
+void build_initial_mdd(const instance &instance,
+                       const bool forward,
+                       initial_mdd_build &build,
+                       initial_mdd_race &race) {
+    build.built_mdd = create_initial_mdd(instance, forward, *build.node_source, build.context, race);
+    if (build.built_mdd == nullptr) {
+        return;
+    }
+    filter_mdd(instance, *build.built_mdd, *build.node_source, build.context);
+    build.complexity = calculate_mdd_complexity(*build.built_mdd);
+    auto no_complexity = std::numeric_limits<long>::max();
+    race.finished_complexity.compare_exchange_strong(no_complexity, build.complexity);
+}
+
+PROCESSING_STATUS_CODE resume_graph_pre_solver_by_mdd(instance &instance) {
+    instance.mdd_node_source = std::make_unique<mdd_node_source>();
+    // the nodes of the resumed mdd start from the bounds and available characters of their matches
+    calculate_simple_upper_bounds(*instance.graph, instance.context);
+
+    auto progress = checkpoint_progress();
+    if (const auto checkpoint_status_code = read_checkpoint(instance, progress);
+        checkpoint_status_code != SUCCESS) {
+        return checkpoint_status_code;
+    }
+    std::cout << "Resuming mdd reduction in round " << progress.refinement_round
+            << " with bounds " << instance.context.lower_bound << " and " << instance.context.upper_bound << "."
+            << std::endl;
+    if (instance.context.lower_bound >= instance.context.upper_bound) {
+        instance.context.upper_bound = instance.context.lower_bound;
+        instance.is_valid_solution = true;
+        instance.active_matches = 0;
+        return SUCCESS;
+    }
+
+    filter_mdd(instance, *instance.mdd, *instance.mdd_node_source, instance.context);
+    create_shared_object(instance);
+    instance.shared_object->refinement_round = progress.refinement_round;
+    run_mdd_reduction_rounds(instance);
+    return SUCCESS;
+}
+
+void create_shared_object(instance &instance) {
     const auto shared_object_size = calculate_shared_object_size(*instance.mdd);
 
     instance.shared_object = static_cast<shared_object *>(mmap(
         nullptr, shared_object_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
 
     instance.shared_object->is_mdd_reduction_complete = false;
-    instance.shared_object->upper_bound = temporaries::upper_bound;
+    instance.shared_object->upper_bound = instance.context.upper_bound;
     instance.shared_object->refinement_round = 1;
-    serialize_initial_mdd(*instance.mdd, instance.shared_object);
+    serialize_initial_mdd(*instance.mdd, instance.shared_object, instance.context.scratch);
+}
+
+void run_mdd_reduction_rounds(instance &instance) {
+    // the graph stays untouched until the matches are filtered by the flat mdd, the reduction rounds run in a child
+    auto restricted_mdd_result = ::restricted_mdd_result();
+    restricted_mdd_result.lower_bound = instance.context.lower_bound;
+    auto restricted_mdd_thread = std::jthread(solve_by_restricted_mdd,
+                                              std::cref(instance),
+                                              instance.context.upper_bound,
+                                              std::ref(restricted_mdd_result));
 
-    while (temporaries::lower_bound < temporaries::upper_bound
+    while (instance.context.lower_bound < instance.context.upper_bound
            && !instance.shared_object->is_mdd_reduction_complete) {
         const double seconds_since_start = get_elapsed_seconds(instance);
 
-        if (seconds_since_start > constants::reduction_timeout) {
+        if (seconds_since_start > constants::reduction_timeout || instance.shared_object->is_memory_limit_reached) {
+            stop_restricted_mdd(instance, restricted_mdd_thread, restricted_mdd_result);
             filter_matches_by_flat_mdd(instance);
             return;
         }
@@ -121,34 +282,60 @@ void reduce_graph_pre_solver_by_mdd(instance &instance) {
         std::cout << "Elapsed time: " << std::fixed << std::setprecision(2) << seconds_since_start << "s. "
                 << "Starting mdd reduction." << std::endl;
 
-        handle_threads_for_mdd_reduction(instance);
+        const auto previous_upper_bound = instance.context.upper_bound;
+        const bool is_flat_mdd_reduced = handle_threads_for_mdd_reduction(instance);
         instance.shared_object->refinement_round++;
-        temporaries::upper_bound = std::min(temporaries::upper_bound, instance.shared_object->upper_bound);
-        temporaries::upper_bound = std::max(temporaries::upper_bound, temporaries::lower_bound);
+        pull_lower_bound_from_restricted_mdd(instance, restricted_mdd_result);
+        instance.context.upper_bound = std::min(instance.context.upper_bound, instance.shared_object->upper_bound);
+        instance.context.upper_bound = std::max(instance.context.upper_bound, instance.context.lower_bound);
+        write_checkpoint(instance);
+
+        // a relaxed round which neither removed flat entries nor lowered the upper bound is repeated by the next one
+        if (constants::max_level_width > 0
+            && !instance.shared_object->is_mdd_reduction_complete
+            && !is_flat_mdd_reduced
+            && instance.context.upper_bound >= previous_upper_bound) {
+            if (!is_fitting_max_level_width(*instance.mdd)) {
+                std::cout << "Relaxed mdd reduction made no progress." << std::endl;
+                stop_restricted_mdd(instance, restricted_mdd_thread, restricted_mdd_result);
+                filter_matches_by_flat_mdd(instance);
+                return;
+            }
+            std::cout << "Relaxed mdd reduction made no progress, refining exactly." << std::endl;
+            constants::max_level_width = 0;
+        }
     }
+    stop_restricted_mdd(instance, restricted_mdd_thread, restricted_mdd_result);
     instance.shared_object->is_mdd_reduction_complete = true;
     filter_matches_by_flat_mdd(instance);
 }
 
+void pull_lower_bound_from_restricted_mdd(instance &instance, restricted_mdd_result &restricted_mdd_result) {
+    auto lock = std::scoped_lock(restricted_mdd_result.mutex);
+    if (restricted_mdd_result.lower_bound > instance.context.lower_bound) {
+        instance.context.lower_bound = restricted_mdd_result.lower_bound;
+        instance.solution.assign(restricted_mdd_result.solution.begin(), restricted_mdd_result.solution.end());
+        std::cout << "Restricted mdd found solution with length " << instance.context.lower_bound << "." << std::endl;
+    }
+}
+
+void stop_restricted_mdd(instance &instance, std::jthread &restricted_mdd_thread, restricted_mdd_result &restricted_mdd_result) {
+    restricted_mdd_thread.request_stop();
+    restricted_mdd_thread.join();
+    pull_lower_bound_from_restricted_mdd(instance, restricted_mdd_result);
+}
+
 void filter_matches_by_flat_mdd(instance &instance) {
     for (auto &match: instance.graph->matches) {
         match.is_active = false;
         match.reversed->is_active = false;
     }
-    auto current_pointer = std::bit_cast<std::byte *>(&instance.shared_object->flat_levels);
-
-    for (size_t level_index = 0; level_index < instance.shared_object->num_levels; ++level_index) {
-        const auto *flat_level = std::bit_cast<struct flat_level *>(current_pointer);
-        current_pointer += sizeof(struct flat_level);
-
-        for (size_t node_index = 0; node_index < flat_level->num_nodes; ++node_index) {
-            auto flat_node = std::bit_cast<struct flat_node *>(current_pointer);
-            const auto match_ptr = static_cast<rflcs_graph::match *>(flat_node->match_ptr);
-            match_ptr->is_active = flat_node->is_active;
-            match_ptr->reversed->is_active = match_ptr->is_active;
-            current_pointer += sizeof(struct flat_node);
-            current_pointer += flat_node->num_edges_out * sizeof(flat_edge);
-        }
+    const auto &shared_object = *instance.shared_object;
+    const auto *flat_nodes = shared_object.nodes();
+    for (std::uint32_t node_index = 0; node_index < shared_object.num_used_nodes(); ++node_index) {
+        const auto match = rflcs_graph::match_by_id(*instance.graph, flat_nodes[node_index].match_id);
+        match->is_active = shared_object.is_node_active(node_index);
+        match->reversed->is_active = match->is_active;
     }
     instance.graph->matches.front().is_active = false;
     instance.graph->matches.back().is_active = false;
@@ -158,7 +345,52 @@ void filter_matches_by_flat_mdd(instance &instance) {
     ));
 }
 
-void handle_threads_for_mdd_reduction(instance &instance) {
+// the mdd the rounds start from, whose levels an exact refinement only widens further
+bool is_fitting_max_level_width(const mdd &mdd) {
+    return std::ranges::all_of(mdd.levels, [](const auto &level) {
+        return level->nodes.size() <= static_cast<std::size_t>(constants::max_level_width);
+    });
+}
+
+// false if the round left the flat mdd as it was
+bool handle_threads_for_mdd_reduction(instance &instance) {
+    instance.shared_object->delta_log.reset();
+    auto deltas = std::vector<flat_delta>();
+    const bool is_round_finished = constants::is_reduction_in_thread
+                                       ? run_reduction_round_in_thread(instance, deltas)
+                                       : run_reduction_round_in_child(instance, deltas);
+
+    instance.context.upper_bound = std::min(instance.context.upper_bound, instance.shared_object->upper_bound);
+    instance.context.upper_bound = std::max(instance.context.upper_bound, instance.context.lower_bound);
+    if (instance.context.lower_bound >= instance.context.upper_bound) {
+        return true;
+    }
+    if (is_round_finished) {
+        const auto node_deltas = std::ranges::count(deltas, NO_SUCC_MATCH_ID, &flat_delta::succ_match_id);
+        std::cout << "Mdd reduction removed " << node_deltas << " nodes and "
+                << static_cast<long>(deltas.size()) - node_deltas << " edges of the flat mdd." << std::endl;
+        prune_by_flat_deltas(deltas,
+                             instance.shared_object->num_levels,
+                             *instance.mdd,
+                             *instance.mdd_node_source,
+                             instance.context.scratch);
+    } else {
+        // a failed round may have stopped between a deactivation and its delta
+        prune_by_flat_mdd(instance.shared_object, *instance.mdd, *instance.mdd_node_source, instance.context.scratch);
+    }
+    // the filter starts from the nodes the deltas touched, and only the entries it removed are cleared in the flat mdd
+    filter_mdd(instance, *instance.mdd, *instance.mdd_node_source, instance.context);
+    auto flat_writeback = mdd_flat_writeback();
+    flat_writeback.attach(*instance.mdd, instance);
+    instance.shared_object->num_levels = std::min(instance.shared_object->num_levels, instance.mdd->levels.size());
+    flat_writeback.write_back(false);
+    mdd_flat_writeback::detach(*instance.mdd);
+    instance.shared_object->active_match_count = flat_writeback.get_number_of_matches_in_mdd() - 1;
+    return !is_round_finished || !deltas.empty();
+}
+
+// false if the child did not exit on its own
+bool run_reduction_round_in_child(instance &instance, std::vector<flat_delta> &deltas) {
     const pid_t pid = fork();
     if (pid == -1) {
         std::cerr << "Fork failed" << std::endl;
@@ -180,26 +412,26 @@ void handle_threads_for_mdd_reduction(instance &instance) {
             std::cerr << "Failed to lock memory" << std::endl;
         }
         set_oom_score_adj(1000);
+        set_reduction_thread_name();
 
-#ifdef __linux__
-        // For Linux
-        prctl(PR_SET_NAME, "rflcs_mdd", 0, 0, 0);
-#elif defined(__APPLE__)
-        // For macOS
-        pthread_setname_np("rflcs_mdd");
-#endif
-
-        if (temporaries::lower_bound >= temporaries::upper_bound) {
-            return;
+        if (instance.context.lower_bound >= instance.context.upper_bound) {
+            exit(0);
         }
-        reduce_by_mdd(instance);
+        reduce_by_mdd(instance, std::stop_token());
         exit(0);
     }
     set_oom_score_adj(-1000);
-    int status;
-    waitpid(pid, &status, 0);
+    // the deltas are drained while the child works, so its writes rarely wait for free space in the log
+    int status = 0;
+    pid_t waited_pid;
+    while ((waited_pid = waitpid(pid, &status, WNOHANG)) == 0) {
+        instance.shared_object->delta_log.drain(deltas);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    instance.shared_object->delta_log.drain(deltas);
+    const bool is_child_exited = waited_pid == pid && WIFEXITED(status);
 
-    if (WIFEXITED(status)) {
+    if (is_child_exited) {
         auto usage = rusage();
         if (getrusage(RUSAGE_CHILDREN, &usage) == 0) {
             instance.mdd_memory_consumption = std::max(instance.mdd_memory_consumption, usage.ru_maxrss);
@@ -209,15 +441,52 @@ void handle_threads_for_mdd_reduction(instance &instance) {
     } else {
         instance.mdd_memory_consumption = -1;
     }
+    return is_child_exited;
+}
 
-    temporaries::upper_bound = std::min(temporaries::upper_bound, instance.shared_object->upper_bound);
-    temporaries::upper_bound = std::max(temporaries::upper_bound, temporaries::lower_bound);
-    if (temporaries::lower_bound >= temporaries::upper_bound) {
-        return;
+/*
+ * The round only reads the graph and the mdd of this process, writes the flat mdd and its delta log like a child,
+ * and takes its nodes from node sources of its own, which account for its memory instead of the maxrss of a child.
+ * It is stopped cooperatively after a refinement batch once the reduction timeout is reached.
+ * False if the round failed, e.g. because an allocation failed.
+ */
+bool run_reduction_round_in_thread(instance &instance, std::vector<flat_delta> &deltas) {
+    auto is_round_done = std::atomic<bool>(false);
+    auto is_round_failed = false;
+    auto reduction_thread = std::jthread([&instance, &is_round_done, &is_round_failed](const std::stop_token &stop_token) {
+        set_reduction_thread_name();
+        try {
+            if (instance.context.lower_bound < instance.context.upper_bound) {
+                reduce_by_mdd(instance, stop_token);
+            }
+        } catch (std::exception &e) {
+            std::cerr << "Mdd reduction failed: " << e.what() << std::endl;
+            is_round_failed = true;
+        }
+        is_round_done.store(true, std::memory_order_release);
+    });
+    while (!is_round_done.load(std::memory_order_acquire)) {
+        instance.shared_object->delta_log.drain(deltas);
+        if (get_elapsed_seconds(instance) > constants::reduction_timeout) {
+            reduction_thread.request_stop();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
-    prune_by_flat_mdd(instance.shared_object, *instance.mdd, *instance.mdd_node_source);
-    filter_mdd(instance, *instance.mdd, *instance.mdd_node_source);
-    serialize_initial_mdd(*instance.mdd, instance.shared_object);
+    reduction_thread.join();
+    instance.shared_object->delta_log.drain(deltas);
+    instance.mdd_memory_consumption = std::max(instance.mdd_memory_consumption,
+                                               instance.shared_object->mdd_memory_consumption);
+    return !is_round_failed;
+}
+
+void set_reduction_thread_name() {
+#ifdef __linux__
+    // For Linux
+    prctl(PR_SET_NAME, "rflcs_mdd", 0, 0, 0);
+#elif defined(__APPLE__)
+    // For macOS
+    pthread_setname_np("rflcs_mdd");
+#endif
 }
 
 __attribute__((noreturn)) void timeout_handler(const int signal) {
@@ -1,7 +1,16 @@
 #pragma once
 
+#include "input_processing.hpp"
 #include "instance.hpp"
 
 void reduce_graph_while_heuristic(instance &instance);
 
+// publishes the upper bound and, if the graph changed, a new reduction snapshot to the heuristic
+void publish_reduction_to_heuristic(const instance &instance);
+
 void reduce_graph_pre_solver(instance &instance);
+
+void reduce_graph_pre_solver_by_mdd(instance &instance);
+
+// continues the rounds of the mdd reduction from the checkpoint instead of building the initial mdds
+PROCESSING_STATUS_CODE resume_graph_pre_solver_by_mdd(instance &instance);
@@ -1,74 +1,72 @@
 #include "sequence_enumeration_solver.hpp"
 #include "../constants.hpp"
 
-void set_solution(instance &instance, const std::vector<flat_node *> &stack, int pointer);
+void set_solution(instance &instance,
+                  const std::vector<std::uint32_t> &stack,
+                  const std::vector<char> &is_on_path,
+                  int pointer);
 
 void solve_enumeration(instance &instance) {
-
-    auto *current_pointer = std::bit_cast<std::byte *>(&instance.shared_object->flat_levels);
-    for (size_t level_index = 0; level_index < instance.shared_object->num_levels; ++level_index) {
-        const auto flat_level = std::bit_cast<const struct flat_level *>(current_pointer);
-        current_pointer += sizeof(struct flat_level);
-        for (size_t node_index = 0; node_index < flat_level->num_nodes; ++node_index) {
-            auto flat_node = std::bit_cast<struct flat_node *>(current_pointer);
-            flat_node->is_active = false;
-            current_pointer += sizeof(struct flat_node);
-            auto *edges = std::bit_cast<flat_edge *>(current_pointer);
-            std::sort(edges, edges + flat_node->num_edges_out, [](const flat_edge &edge_1, const flat_edge &edge_2) {
-                const auto match_1 = static_cast<rflcs_graph::match *>(edge_1.edge_node->match_ptr);
-                const auto match_2 = static_cast<rflcs_graph::match *>(edge_2.edge_node->match_ptr);
-                return std::tie(match_1->extension->position_1,
-                                match_1->extension->position_2)
-                       <
-                       std::tie(match_2->extension->position_1,
-                                match_2->extension->position_2);
-            });
-            current_pointer += flat_node->num_edges_out * sizeof(flat_edge);
-        }
+    auto &shared_object = *instance.shared_object;
+    const auto *flat_nodes = shared_object.nodes();
+    auto *flat_edges = shared_object.edges();
+    const auto num_used_nodes = shared_object.num_used_nodes();
+    for (std::uint32_t node_index = 0; node_index < num_used_nodes; ++node_index) {
+        const auto &flat_node = flat_nodes[node_index];
+        auto *edges = flat_edges + flat_node.first_edge;
+        std::sort(edges, edges + flat_node.num_edges_out, [&](const flat_edge &edge_1, const flat_edge &edge_2) {
+            const auto match_1 = rflcs_graph::match_by_id(*instance.graph, flat_nodes[edge_1.node_index].match_id);
+            const auto match_2 = rflcs_graph::match_by_id(*instance.graph, flat_nodes[edge_2.node_index].match_id);
+            return std::tie(match_1->extension->position_1,
+                            match_1->extension->position_2)
+                   <
+                   std::tie(match_2->extension->position_1,
+                            match_2->extension->position_2);
+        });
     }
 
-    current_pointer = std::bit_cast<std::byte *>(&instance.shared_object->flat_levels);
-    current_pointer += sizeof(flat_level);
-    const auto *root_node = std::bit_cast<flat_node *>(current_pointer);
+    const auto &root_node = flat_nodes[shared_object.levels()[0].first_node];
 
-    auto stack_vector = std::vector<flat_node *>();
-    stack_vector.reserve(constants::alphabet_size * temporaries::upper_bound);
+    auto stack_vector = std::vector<std::uint32_t>();
+    stack_vector.reserve(constants::alphabet_size * instance.context.upper_bound);
+    auto is_on_path = std::vector<char>(shared_object.layout.num_nodes, false);
 
     const auto stack = stack_vector.data();
     int stack_pointer = -1;
-    for (size_t i = 0; i < root_node->num_edges_out; i++) {
-        stack[++stack_pointer] = root_node->edges_out[i].edge_node;
+    for (std::uint32_t i = 0; i < root_node.num_edges_out; i++) {
+        stack[++stack_pointer] = flat_edges[root_node.first_edge + i].node_index;
     }
 
     int depth = 0;
     auto used_characters = Character_set();
     used_characters.reset();
-    flat_node *current_node;
     while (stack_pointer >= 0) {
-        current_node = stack[stack_pointer];
-        if (current_node->is_active) {
-            current_node->is_active = false;
-            used_characters.reset(current_node->character);
+        const auto current_node_index = stack[stack_pointer];
+        const auto &current_node = flat_nodes[current_node_index];
+        if (is_on_path[current_node_index]) {
+            is_on_path[current_node_index] = false;
+            used_characters.reset(current_node.character);
             --depth;
             --stack_pointer;
         } else {
-            current_node->is_active = true;
-            used_characters.set(current_node->character);
+            is_on_path[current_node_index] = true;
+            used_characters.set(current_node.character);
             ++depth;
-            if (depth > temporaries::lower_bound) {
-                set_solution(instance, stack_vector, stack_pointer);
-                temporaries::lower_bound = depth;
-                if(temporaries::lower_bound >= temporaries::upper_bound) {
+            if (depth > instance.context.lower_bound) {
+                set_solution(instance, stack_vector, is_on_path, stack_pointer);
+                instance.context.lower_bound = depth;
+                if(instance.context.lower_bound >= instance.context.upper_bound) {
                     instance.is_valid_solution = true;
                     return;
                 }
             }
             int position_2_min = std::numeric_limits<int>::max();
-            for (size_t i = 0; i < current_node->num_edges_out; ++i) {
-                if (flat_node *potential_node = current_node->edges_out[i].edge_node;
-                    position_2_min > potential_node->position_2 && !used_characters.test(potential_node->character)) {
-                    stack[++stack_pointer] = potential_node;
-                    position_2_min = potential_node->position_2;
+            for (std::uint32_t i = 0; i < current_node.num_edges_out; ++i) {
+                if (const auto potential_node_index = flat_edges[current_node.first_edge + i].node_index;
+                    position_2_min > flat_nodes[potential_node_index].position_2
+                    && !used_characters.test(flat_nodes[potential_node_index].character)) {
+                    stack[++stack_pointer] = potential_node_index;
+                    position_2_min = flat_nodes[potential_node_index].position_2;
                 }
             }
         }
@@ -76,11 +74,15 @@ void solve_enumeration(instance &instance) {
     instance.is_valid_solution = true;
 }
 
-void set_solution(instance &instance, const std::vector<flat_node *> &stack, const int pointer) {
+void set_solution(instance &instance,
+                  const std::vector<std::uint32_t> &stack,
+                  const std::vector<char> &is_on_path,
+                  const int pointer) {
+    const auto *flat_nodes = instance.shared_object->nodes();
     instance.solution.clear();
     for (int i = 0; i <= pointer; i++) {
-        if (const auto *node = stack[i]; node->is_active) {
-            instance.solution.push_back(node->character);
+        if (is_on_path[stack[i]]) {
+            instance.solution.push_back(flat_nodes[stack[i]].character);
         }
     }
 }
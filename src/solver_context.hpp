@@ -0,0 +1,74 @@
+#pragma once
+
+#include "character_set.hpp"
+#include "constants.hpp"
+#include "absl/container/flat_hash_set.h"
+
+#include <algorithm>
+#include <limits>
+#include <stop_token>
+#include <utility>
+#include <vector>
+
+struct node;
+
+namespace rflcs_graph {
+    struct match;
+}
+
+/*
+ * Buffers of the graph and mdd kernels. They are only valid during a single kernel call
+ * and belong to the thread working with the owning context.
+ */
+struct scratch_space {
+    Character_set temp_character_set_1 = Character_set();
+    Character_set temp_character_set_2 = Character_set();
+    Character_set old_characters_on_paths_to_some_sink = Character_set();
+    Character_set old_characters_on_all_paths_to_lower_bound_levels = Character_set();
+    Character_set old_characters_on_paths_to_root = Character_set();
+    Character_set old_characters_on_all_paths_to_root = Character_set();
+    std::vector<unsigned int> succ_indices = std::vector<unsigned int>(constants::alphabet_size);
+    std::vector<char> is_unlinking = std::vector<char>(constants::alphabet_size);
+    std::vector<int> min_positions_2 = std::vector<int>(constants::alphabet_size);
+    std::vector<char> is_nearest_successor = std::vector<char>(); // indexed by match id
+    std::vector<rflcs_graph::match *> succ_matches_by_position_1 = std::vector<rflcs_graph::match *>();
+    std::vector<unsigned int> unlinked_out_edges = std::vector<unsigned int>(); // out edge indices, per node descending
+    std::vector<node *> level_nodes = std::vector<node *>();
+    std::vector<unsigned int> succ_positions = std::vector<unsigned int>(); // level positions, per node ascending
+    std::vector<std::size_t> first_succ_positions = std::vector<std::size_t>(); // per node, plus the end
+    std::vector<unsigned int> level_node_order = std::vector<unsigned int>();
+    std::vector<unsigned int> representatives = std::vector<unsigned int>(); // level positions
+    std::vector<int> chaining_counters = std::vector<int>(); // per level position, a counter per character
+    std::vector<int> succ_chaining_counters = std::vector<int>(); // of the level below
+    std::vector<absl::flat_hash_set<int> > valid_matches_sets = std::vector<absl::flat_hash_set<int> >(); // match ids
+    std::vector<absl::flat_hash_set<long> > valid_edges_sets = std::vector<absl::flat_hash_set<long> >();
+    absl::flat_hash_set<int> removed_matches = absl::flat_hash_set<int>(); // match ids
+    absl::flat_hash_set<int> active_match_ids = absl::flat_hash_set<int>();
+    absl::flat_hash_set<long> removed_edges = absl::flat_hash_set<long>();
+    absl::flat_hash_set<void *> matches = absl::flat_hash_set<void *>();
+    absl::flat_hash_set<void *> matches_on_level = absl::flat_hash_set<void *>();
+    absl::flat_hash_set<long> edges = absl::flat_hash_set<long>();
+};
+
+/*
+ * State of a single solve. Threads working on the same solve use copies of the context,
+ * so every thread has its own scratch space, and merge their bounds back when they are done.
+ * The character sets are sized by the alphabet, so a context has to be created after the alphabet reduction.
+ */
+struct solver_context {
+    int lower_bound = 0;
+    int upper_bound = std::numeric_limits<int>::max();
+    std::vector<int> chaining_numbers = std::vector<int>(); // indexed by character
+    std::stop_token stop_token = std::stop_token(); // of the reduction thread, kernels return early once requested
+    scratch_space scratch = scratch_space();
+    std::vector<scratch_space> worker_scratch = std::vector<scratch_space>(); // of the pool workers besides the caller
+
+    scratch_space &scratch_of_worker(const std::size_t worker_index) {
+        return worker_index == 0 ? scratch : worker_scratch[worker_index - 1];
+    }
+
+    void merge_bounds(const solver_context &other) {
+        lower_bound = std::max(lower_bound, other.lower_bound);
+        upper_bound = std::min(upper_bound, other.upper_bound);
+    }
+};
@@ -1,14 +0,0 @@
-#include "temporaries.hpp"
-
-Character_set temporaries::temp_character_set_1;
-Character_set temporaries::temp_character_set_2;
-Character_set temporaries::old_characters_on_paths_to_some_sink;
-Character_set temporaries::old_characters_on_all_paths_to_lower_bound_levels;
-Character_set temporaries::old_characters_on_paths_to_root;
-Character_set temporaries::old_characters_on_all_paths_to_root;
-std::vector<int> temporaries::chaining_numbers;
-std::vector<long> temporaries::node_character_count;
-std::vector<long> temporaries::incoming_edge_character_count;
-std::vector<long> temporaries::outgoing_edge_character_count;
-int temporaries::lower_bound;
-int temporaries::upper_bound;
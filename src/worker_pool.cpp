@@ -0,0 +1,114 @@
+#include "worker_pool.hpp"
+
+#include <algorithm>
+#include <unistd.h>
+
+thread_local bool is_running_task = false;
+
+// restores the state of the enclosing task, so a nested run does not end it
+struct running_task_scope {
+    const bool was_running_task = is_running_task;
+
+    running_task_scope() {
+        is_running_task = true;
+    }
+
+    ~running_task_scope() {
+        is_running_task = was_running_task;
+    }
+
+    running_task_scope(const running_task_scope &) = delete;
+
+    running_task_scope &operator=(const running_task_scope &) = delete;
+};
+
+worker_pool::worker_pool(const std::size_t number_of_threads) {
+    threads.reserve(number_of_threads);
+    for (std::size_t thread_index = 0; thread_index < number_of_threads; ++thread_index) {
+        threads.emplace_back(&worker_pool::work, this, thread_index + 1);
+    }
+}
+
+worker_pool::~worker_pool() {
+    {
+        auto lock = std::scoped_lock(state_mutex);
+        is_stopping = true;
+    }
+    work_available.notify_all();
+    threads.clear();
+}
+
+void worker_pool::run(const std::size_t number_of_tasks, const worker_task_type &task) {
+    if (threads.empty() || number_of_tasks <= 1 || is_running_task || !run_mutex.try_lock()) {
+        const auto scope = running_task_scope();
+        for (std::size_t task_index = 0; task_index < number_of_tasks; ++task_index) {
+            task(0, task_index);
+        }
+        return;
+    }
+
+    {
+        auto lock = std::scoped_lock(state_mutex);
+        current_task = &task;
+        number_of_current_tasks = number_of_tasks;
+        next_task_index = 0;
+        busy_threads = threads.size();
+        generation++;
+    }
+    work_available.notify_all();
+
+    take_tasks(0);
+
+    {
+        auto lock = std::unique_lock(state_mutex);
+        work_done.wait(lock, [this] { return busy_threads == 0; });
+        current_task = nullptr;
+    }
+    run_mutex.unlock();
+}
+
+void worker_pool::work(const std::size_t worker_index) {
+    long seen_generation = 0;
+    while (true) {
+        {
+            auto lock = std::unique_lock(state_mutex);
+            work_available.wait(lock, [this, seen_generation] {
+                return is_stopping || generation != seen_generation;
+            });
+            if (is_stopping) {
+                return;
+            }
+            seen_generation = generation;
+        }
+
+        take_tasks(worker_index);
+
+        auto lock = std::scoped_lock(state_mutex);
+        if (--busy_threads == 0) {
+            work_done.notify_one();
+        }
+    }
+}
+
+void worker_pool::take_tasks(const std::size_t worker_index) {
+    const auto scope = running_task_scope();
+    for (auto task_index = next_task_index.fetch_add(1); task_index < number_of_current_tasks;
+         task_index = next_task_index.fetch_add(1)) {
+        (*current_task)(worker_index, task_index);
+    }
+}
+
+// the forward and backward initial mdd builds may ask for the pool at the same time
+worker_pool &get_worker_pool() {
+    static auto pool_mutex = std::mutex();
+    static worker_pool *pool = nullptr;
+    static pid_t pool_process = 0;
+    auto lock = std::scoped_lock(pool_mutex);
+    if (pool == nullptr || pool_process != getpid()) {
+        // the threads of an inherited pool do not exist in a forked child, so it is left alone
+        const auto number_of_threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        pool = new worker_pool(number_of_threads);
+        pool_process = getpid();
+    }
+    return *pool;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::function<void(std::size_t worker_index, std::size_t task_index)> worker_task_type;
+
+/*
+ * Fixed set of threads running the tasks of one call to run at a time, the calling thread works as worker 0.
+ * A call made from inside a task or while another thread uses the pool runs all tasks on the calling thread,
+ * so the result never depends on how many workers were available.
+ */
+struct worker_pool {
+    explicit worker_pool(std::size_t number_of_threads);
+
+    ~worker_pool();
+
+    worker_pool(const worker_pool &) = delete;
+
+    worker_pool &operator=(const worker_pool &) = delete;
+
+    [[nodiscard]] std::size_t number_of_workers() const {
+        return threads.size() + 1;
+    }
+
+    void run(std::size_t number_of_tasks, const worker_task_type &task);
+
+private:
+    std::vector<std::jthread> threads = std::vector<std::jthread>();
+    std::mutex run_mutex = std::mutex();
+    std::mutex state_mutex = std::mutex();
+    std::condition_variable work_available = std::condition_variable();
+    std::condition_variable work_done = std::condition_variable();
+    const worker_task_type *current_task = nullptr;
+    std::size_t number_of_current_tasks = 0;
+    std::atomic<std::size_t> next_task_index = 0;
+    std::size_t busy_threads = 0;
+    long generation = 0;
+    bool is_stopping = false;
+
+    void work(std::size_t worker_index);
+
+    void take_tasks(std::size_t worker_index);
+};
+
+// one pool per process, a forked child builds its own on first use
+worker_pool &get_worker_pool();